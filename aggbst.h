@@ -0,0 +1,172 @@
+/***********************************************************************
+ * Component:
+ *    Aggregate Binary Search Tree
+ * Author:
+ *    Ryan Walker
+ * Summary:
+ *    A BST whose nodes also keep a running total of their subtree
+ * under some monoid: sum, min, max, or anything with an identity
+ * and an associative combine.  A total over any range of keys is
+ * then O(log n) instead of a walk over the range.
+ *
+ *    A monoid is a struct with
+ *       typedef ... value_type;
+ *       static value_type identity();
+ *       static value_type of(const T & t);        // one item's worth
+ *       static value_type combine(const value_type & a,
+ *                                 const value_type & b);
+ * combine is only ever called with a's items before b's, so it
+ * need not be commutative.
+ ************************************************************************/
+
+#ifndef AGGBST_H
+#define AGGBST_H
+
+#include "bst.h"      // for BST
+#include <limits>
+
+using namespace std;
+
+/*****************************************************************
+ * SUM, MIN and MAX
+ * The usual monoids
+ *****************************************************************/
+template <class T>
+struct SumAggregate
+{
+   typedef T value_type;
+   static T identity()                       { return T();    }
+   static T of(const T & t)                  { return t;      }
+   static T combine(const T & a, const T & b) { return a + b;  }
+};
+
+template <class T>
+struct MinAggregate
+{
+   typedef T value_type;
+   static T identity()                       { return numeric_limits<T>::max(); }
+   static T of(const T & t)                  { return t;                  }
+   static T combine(const T & a, const T & b) { return b < a ? b : a;      }
+};
+
+template <class T>
+struct MaxAggregate
+{
+   typedef T value_type;
+   static T identity()                       { return numeric_limits<T>::lowest(); }
+   static T of(const T & t)                  { return t;                  }
+   static T combine(const T & a, const T & b) { return a < b ? b : a;      }
+};
+
+/*****************************************************************
+ * AGGREGATE NODE
+ * A BinaryNode with its subtree's total
+ *****************************************************************/
+template <class T, class Monoid>
+struct AggregateNode : public BinaryNode <T>
+{
+   typename Monoid::value_type total;
+
+   AggregateNode(const T & t) : BinaryNode <T> (t), total(Monoid::of(t)) {}
+};
+
+/*****************************************************************
+ * AGGREGATE BINARY SEARCH TREE
+ * Everything BST does, plus total() and aggregate().  BST keeps
+ * the totals right through its rotations by calling sum().
+ *****************************************************************/
+template <class T, class Monoid = SumAggregate <T> >
+class AggregateBST : public BST <T>
+{
+public:
+   typedef typename Monoid::value_type value_type;
+
+   // constructor
+   AggregateBST()
+   {
+      this->newNode = &make;
+      this->freeNode = &drop;
+      this->sumNode = &sum;
+   }
+
+   // the total of every item
+   value_type total() const          { return totalOf(this->root); }
+
+   // the total of the items in [lo, hi]
+   value_type aggregate(const T & lo, const T & hi) const;
+
+private:
+   typedef AggregateNode <T, Monoid> Node;
+
+   static value_type totalOf(const BinaryNode <T> * node)
+   {
+      return node ? static_cast <const Node *> (node)->total : Monoid::identity();
+   }
+
+   // how BST makes, frees and sums our nodes
+   static BinaryNode <T> * make(const T & t)  { return new Node(t); }
+   static void drop(BinaryNode <T> * node)    { delete static_cast <Node *> (node); }
+   static void sum(BinaryNode <T> * node)
+   {
+      static_cast <Node *> (node)->total =
+         Monoid::combine(Monoid::combine(totalOf(node->pLeft), Monoid::of(node->data)),
+                         totalOf(node->pRight));
+   }
+};
+
+/****************************************************
+ * AGGREGATE BST :: AGGREGATE
+ * Go down to the first node inside [lo, hi].  Then
+ * down its left side every node >= lo comes with its
+ * whole right subtree, and down its right side every
+ * node <= hi comes with its whole left subtree.
+ ****************************************************/
+template <class T, class Monoid>
+typename Monoid::value_type AggregateBST <T, Monoid> :: aggregate(const T & lo,
+                                                                  const T & hi) const
+{
+   const BinaryNode <T> * split = this->root;
+   while (split)
+   {
+      if (split->data < lo)
+         split = split->pRight;
+      else if (hi < split->data)
+         split = split->pLeft;
+      else
+         break;
+   }
+   if (split == NULL)
+      return Monoid::identity();
+
+   // what each step finds comes before what we have so far
+   value_type left = Monoid::identity();
+   for (const BinaryNode <T> * node = split->pLeft; node; )
+   {
+      if (node->data < lo)
+         node = node->pRight;
+      else
+      {
+         left = Monoid::combine(Monoid::combine(Monoid::of(node->data),
+                                                totalOf(node->pRight)), left);
+         node = node->pLeft;
+      }
+   }
+
+   // ... and here after
+   value_type right = Monoid::identity();
+   for (const BinaryNode <T> * node = split->pRight; node; )
+   {
+      if (hi < node->data)
+         node = node->pLeft;
+      else
+      {
+         right = Monoid::combine(right, Monoid::combine(totalOf(node->pLeft),
+                                                        Monoid::of(node->data)));
+         node = node->pRight;
+      }
+   }
+
+   return Monoid::combine(Monoid::combine(left, Monoid::of(split->data)), right);
+}
+
+#endif // AGGBST_H
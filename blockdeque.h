@@ -0,0 +1,336 @@
+/***************************************************************
+ * File: blockdeque.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the BlockDeque class.
+ *    Same interface as Deque, but the items live in fixed-size
+ * blocks that never move once they are allocated.  A small
+ * circular map of block pointers is the only thing that ever
+ * grows, so pushes don't copy items and references to items
+ * stay good until that item is popped.
+ ***************************************************************/
+#ifndef BlockDeque_H
+#define BlockDeque_H
+
+#include <cassert>
+#include <iostream>
+
+using namespace std;
+
+/************************************************
+ * BlockDeque
+ * A double-ended queue made of blocks of B items.
+ * Blocks freed at either end are kept in a small
+ * cache so a deque that breathes in and out does
+ * not keep going back to the allocator.
+ ***********************************************/
+template <class T, int B = 64>
+class BlockDeque
+{
+public:
+
+   T ** map;          // circular array of block pointers
+   int mapCap;        // how many block pointers fit in the map (power of two)
+   int mapFront;      // index in the map of the front block
+   int numBlocks;     // how many blocks are in use
+   int first;         // index of the front item inside the front block
+   int numItems;      // how many items are currently in the BlockDeque?
+
+   T * cache[4];      // blocks waiting to be reused
+   int numCached;     // how many blocks are in the cache
+
+   // Default constructor : empty and kinda useless
+   BlockDeque() : map(NULL), mapCap(0), mapFront(0), numBlocks(0),
+                  first(0), numItems(0), numCached(0) {}
+
+   // Copy constructor : copy it
+   BlockDeque(const BlockDeque & rhs) throw (const char *);
+
+   // Destructor : free everything
+   ~BlockDeque()        { release(); }
+
+   // Assignment operator
+   BlockDeque <T, B> & operator=(const BlockDeque <T, B> & rhs) throw (const char *);
+
+   // Is the BlockDeque empty?
+   bool empty() const   { return numItems == 0;       }
+
+   // Number of items within BlockDeque
+   int size()   const   { return numItems;            }
+
+   // Space available without allocating another block
+   int capacity() const { return (numBlocks + numCached) * B; }
+
+   // Clears the BlockDeque of items, handing the blocks to the cache
+   void clear();
+
+   // Adds an item to the front of the BlockDeque
+   void push_front(const T & add)  throw (const char *);
+
+   // Adds an item to the back of the BlockDeque
+   void push_back(const T & add)  throw (const char *);
+
+   // Removes the front item from the BlockDeque
+   void pop_front()   throw (const char *);
+
+   // Removes the back item from the BlockDeque
+   void pop_back()   throw (const char *);
+
+   // Returns the item at the front of the BlockDeque
+   T & front()   throw (const char *);
+
+   // Returns the item at the back of the BlockDeque
+   T & back()  throw (const char *);
+
+   // Returns the item i places from the front
+   T & operator[](int i)             { return at(first + i); }
+   const T & operator[](int i) const { return at(first + i); }
+
+private:
+   // the item at a position counted from the start of the front block
+   T & at(int pos) const
+   {
+      return map[(mapFront + pos / B) & (mapCap - 1)][pos % B];
+   }
+
+   // get a block, from the cache if we can
+   T * newBlock();
+
+   // give a block back to the cache, or to the allocator if the cache is full
+   void freeBlock(T * block);
+
+   // make room in the map for one more block
+   void growMap();
+
+   // free every block and the map
+   void release();
+};
+
+/*******************************************
+ * BlockDeque :: COPY CONSTRUCTOR
+ *******************************************/
+template <class T, int B>
+BlockDeque <T, B> :: BlockDeque(const BlockDeque <T, B> & rhs) throw (const char *)
+   : map(NULL), mapCap(0), mapFront(0), numBlocks(0),
+     first(0), numItems(0), numCached(0)
+{
+   *this = rhs;
+}
+
+/************************************
+ * BlockDeque :: operator=
+ * Copies the items in order into a
+ * fresh set of blocks.
+ ************************************/
+template <class T, int B>
+BlockDeque <T, B> & BlockDeque <T, B> :: operator=(const BlockDeque <T, B> & rhs)
+   throw (const char *)
+{
+   if (this == &rhs)
+      return *this;
+
+   clear();
+   for (int i = 0; i < rhs.numItems; i++)
+      push_back(rhs[i]);
+
+   return *this;
+}
+
+/*******************************************
+ * BlockDeque :: release
+ * Frees every block, cached or not, and the map.
+ *******************************************/
+template <class T, int B>
+void BlockDeque <T, B> :: release()
+{
+   for (int i = 0; i < numBlocks; i++)
+      delete [] map[(mapFront + i) & (mapCap - 1)];
+   for (int i = 0; i < numCached; i++)
+      delete [] cache[i];
+   delete [] map;
+
+   map = NULL;
+   mapCap = mapFront = numBlocks = first = numItems = numCached = 0;
+}
+
+/*******************************************
+ * BlockDeque :: clear
+ *******************************************/
+template <class T, int B>
+void BlockDeque <T, B> :: clear()
+{
+   for (int i = 0; i < numBlocks; i++)
+      freeBlock(map[(mapFront + i) & (mapCap - 1)]);
+
+   mapFront = numBlocks = first = numItems = 0;
+}
+
+/*******************************************
+ * BlockDeque :: newBlock
+ *******************************************/
+template <class T, int B>
+T * BlockDeque <T, B> :: newBlock()
+{
+   if (numCached)
+      return cache[--numCached];
+   return new T[B];
+}
+
+/*******************************************
+ * BlockDeque :: freeBlock
+ *******************************************/
+template <class T, int B>
+void BlockDeque <T, B> :: freeBlock(T * block)
+{
+   if (numCached < 4)
+      cache[numCached++] = block;
+   else
+      delete [] block;
+}
+
+/*******************************************
+ * BlockDeque :: growMap
+ * Doubles the map.  Only block pointers are
+ * copied; the items themselves stay put.
+ *******************************************/
+template <class T, int B>
+void BlockDeque <T, B> :: growMap()
+{
+   int newCap = mapCap ? mapCap * 2 : 8;
+   T ** newMap = new T*[newCap];
+
+   for (int i = 0; i < numBlocks; i++)
+      newMap[i] = map[(mapFront + i) & (mapCap - 1)];
+
+   delete [] map;
+   map = newMap;
+   mapCap = newCap;
+   mapFront = 0;
+}
+
+/*****************************************
+ * BlockDeque :: push_front
+ * Adds an item onto front of the BlockDeque,
+ * opening a new front block if needed.
+ *****************************************/
+template <class T, int B>
+void BlockDeque <T, B> :: push_front(const T & add)  throw (const char *)
+{
+   try
+   {
+      if (first == 0)
+      {
+         if (numBlocks == mapCap)
+            growMap();
+         T * block = newBlock();
+         mapFront = (mapFront - 1) & (mapCap - 1);
+         map[mapFront] = block;
+         numBlocks++;
+         first = B;
+      }
+
+      first--;
+      at(first) = add;
+      numItems++;
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate a new block for BlockDeque";
+   }
+}
+
+/*****************************************
+ * BlockDeque :: push_back
+ * Adds an item onto the back of the BlockDeque,
+ * opening a new back block if needed.
+ *****************************************/
+template <class T, int B>
+void BlockDeque <T, B> :: push_back(const T & add)  throw (const char *)
+{
+   try
+   {
+      if (first + numItems == numBlocks * B)
+      {
+         if (numBlocks == mapCap)
+            growMap();
+         T * block = newBlock();
+         map[(mapFront + numBlocks) & (mapCap - 1)] = block;
+         numBlocks++;
+      }
+
+      at(first + numItems) = add;
+      numItems++;
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate a new block for BlockDeque";
+   }
+}
+
+/*******************************************
+ * BlockDeque :: pop_front
+ * Removes the front item, letting go of the
+ * front block once it is empty.
+ *******************************************/
+template <class T, int B>
+void BlockDeque <T, B> :: pop_front()   throw (const char *)
+{
+   if (!size())
+      throw "ERROR: unable to pop from the front of empty deque";
+
+   first++;
+   numItems--;
+   if (first == B || numItems == 0)
+   {
+      freeBlock(map[mapFront]);
+      mapFront = (mapFront + 1) & (mapCap - 1);
+      numBlocks--;
+      first = 0;
+   }
+}
+
+/*******************************************
+ * BlockDeque :: pop_back
+ * Removes the back item, letting go of the
+ * back block once it is empty.
+ *******************************************/
+template <class T, int B>
+void BlockDeque <T, B> :: pop_back()   throw (const char *)
+{
+   if (!size())
+      throw "ERROR: unable to pop from the back of empty deque";
+
+   numItems--;
+   if (first + numItems <= (numBlocks - 1) * B)
+   {
+      freeBlock(map[(mapFront + numBlocks - 1) & (mapCap - 1)]);
+      numBlocks--;
+   }
+   if (numItems == 0)
+      first = 0;
+}
+
+/******************************************
+ * BlockDeque :: front
+ * Returns the front item on the BlockDeque
+ *******************************************/
+template <class T, int B>
+T & BlockDeque <T, B> :: front()   throw (const char *)
+{
+   if (numItems == 0)
+      throw "ERROR: unable to access data from an empty deque";
+   return at(first);
+}
+
+/*******************************************
+ * BlockDeque :: back
+ * Returns the back item on the BlockDeque
+ *******************************************/
+template <class T, int B>
+T & BlockDeque <T, B> :: back()   throw (const char *)
+{
+   if (numItems == 0)
+      throw "ERROR: unable to access data from an empty deque";
+   return at(first + numItems - 1);
+}
+
+#endif // BlockDeque_H
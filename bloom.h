@@ -0,0 +1,263 @@
+/***************************************************************
+ * File: bloom.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the BloomFilter class.  A
+ *    blocked Bloom filter that Set and BST can put in front of
+ * find() so most misses never search at all.  A key's bits all
+ * fall in one 512-bit block, one cache line, so a check is a single
+ * memory access however many bits a key sets.
+ *
+ *    The filter works on hashes, not keys.  The container hashes
+ * the key and hands the filter the hash.  The filter only adds; it
+ * can't remove.  The container counts erasures instead and
+ * rebuilds the filter from its items once too many keys are gone,
+ * or once it holds more keys than it was sized for.
+ ***************************************************************/
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+
+using namespace std;
+
+// bits per block, one 64-byte cache line
+#define BLOOM_BLOCK_BITS 512
+
+/************************************************
+ * BloomFilter
+ * bitsPerKey trades memory for false positives:
+ * 8 gives about 2.5%, 10 about 1%, 16 about 0.1%.
+ * The counters behind falsePositiveRate() are
+ * atomic, so threads may share a const Set or
+ * BST and call find() at once.  add() and
+ * reset() still need the container to itself.
+ ***********************************************/
+class BloomFilter
+{
+public:
+   // construct : bitsPerKey bits for each key, room for numKeys
+   BloomFilter(int bitsPerKey = 10, int numKeys = 0) throw (const char *);
+
+   // copy constructor
+   BloomFilter(const BloomFilter & rhs) throw (const char *);
+
+   // destructor
+   ~BloomFilter()                { delete [] storage; }
+
+   // assignment operator
+   BloomFilter & operator = (const BloomFilter & rhs) throw (const char *);
+
+   // empty it and size it for numKeys keys
+   void reset(int numKeys) throw (const char *);
+
+   // add the key with hash h
+   void add(size_t h);
+
+   // false means the key with hash h is certainly not there
+   bool mayContain(size_t h) const;
+
+   // the container tells us when mayContain() was wrong...
+   void falsePositive() const    { numFalse.fetch_add(1, memory_order_relaxed); }
+
+   // ... and when one of our keys went away
+   void erased()                 { numErased++; }
+
+   // would a rebuild help?  Too many keys added, or too many gone.
+   bool stale() const
+   {
+      return numKeys > capacity || (numErased > 64 && numErased * 2 > numKeys);
+   }
+
+   // of the lookups that were not there, the fraction we let through
+   double falsePositiveRate() const
+   {
+      long long falses = numFalse.load(memory_order_relaxed);
+      long long negatives = numRejected.load(memory_order_relaxed) + falses;
+      return negatives ? (double)falses / negatives : 0.0;
+   }
+
+   // start counting again
+   void resetStats() const       { numRejected.store(0); numFalse.store(0); }
+
+   int bitsPerKey;               // what each key is budgeted
+   int numProbes;                // bits set per key
+
+private:
+   // the block for h, and the bits in it
+   int blockOf(size_t h) const;
+   static unsigned long long bitsOf(size_t h, int i, int & word);
+
+   unsigned long long * storage;      // what was allocated
+   unsigned long long * blocks;       // storage rounded up to a cache line
+   int numBlocks;
+   int capacity;                      // keys it was sized for
+   int numKeys;                       // keys added since the last reset
+   int numErased;                     // of those, how many the container dropped
+   mutable atomic<long long> numRejected;  // lookups we answered "no"
+   mutable atomic<long long> numFalse;     // lookups we answered "maybe" that weren't there
+};
+
+/*******************************************
+ * BloomFilter :: CONSTRUCTOR
+ * The best number of bits to set per key is
+ * bitsPerKey * ln 2.
+ *******************************************/
+inline BloomFilter :: BloomFilter(int bitsPerKey, int numKeys) throw (const char *)
+   : bitsPerKey(bitsPerKey), numProbes((bitsPerKey * 69 + 50) / 100),
+     storage(NULL), blocks(NULL), numBlocks(0), capacity(0),
+     numKeys(0), numErased(0), numRejected(0), numFalse(0)
+{
+   assert(bitsPerKey > 0);
+   if (numProbes < 1)
+      numProbes = 1;
+   if (numProbes > 16)
+      numProbes = 16;
+   reset(numKeys);
+}
+
+/*******************************************
+ * BloomFilter :: COPY CONSTRUCTOR
+ *******************************************/
+inline BloomFilter :: BloomFilter(const BloomFilter & rhs) throw (const char *)
+   : storage(NULL), blocks(NULL), numBlocks(0)
+{
+   *this = rhs;
+}
+
+/*******************************************
+ * BloomFilter :: ASSIGNMENT OPERATOR
+ *******************************************/
+inline BloomFilter & BloomFilter :: operator = (const BloomFilter & rhs)
+   throw (const char *)
+{
+   if (this == &rhs)
+      return *this;
+
+   bitsPerKey = rhs.bitsPerKey;
+   numProbes = rhs.numProbes;
+   reset(rhs.capacity);
+   for (int i = 0; i < numBlocks * 8; i++)
+      blocks[i] = rhs.blocks[i];
+   numKeys = rhs.numKeys;
+   numErased = rhs.numErased;
+   numRejected.store(rhs.numRejected.load());
+   numFalse.store(rhs.numFalse.load());
+   return *this;
+}
+
+/*******************************************
+ * BloomFilter :: reset
+ *******************************************/
+inline void BloomFilter :: reset(int numKeys) throw (const char *)
+{
+   if (numKeys < 64)
+      numKeys = 64;
+   int needed = (int)(((long long)numKeys * bitsPerKey + BLOOM_BLOCK_BITS - 1) /
+                      BLOOM_BLOCK_BITS);
+
+   if (needed != numBlocks)
+   {
+      unsigned long long * nStorage;
+      try
+      {
+         // one spare block so we can line up on 64 bytes
+         nStorage = new unsigned long long[(needed + 1) * 8];
+      }
+      catch (std::bad_alloc)
+      {
+         throw "ERROR: Unable to allocate buffer";
+      }
+      delete [] storage;
+      storage = nStorage;
+      blocks = (unsigned long long *)(((size_t)storage + 63) & ~(size_t)63);
+      numBlocks = needed;
+   }
+
+   for (int i = 0; i < numBlocks * 8; i++)
+      blocks[i] = 0;
+   capacity = numKeys;
+   this->numKeys = 0;
+   numErased = 0;
+}
+
+/*******************************************
+ * BloomFilter :: blockOf
+ * The hash is mixed first: std::hash of an
+ * int is the int itself.  Then the top 32
+ * bits are scaled onto [0, numBlocks) with a
+ * multiply instead of a divide.
+ *******************************************/
+inline int BloomFilter :: blockOf(size_t h) const
+{
+   unsigned long long m = (unsigned long long)h * 0x9E3779B97F4A7C15ULL;
+   return (int)(((m >> 32) * (unsigned long long)numBlocks) >> 32);
+}
+
+/*******************************************
+ * BloomFilter :: bitsOf
+ * Probe i of h: 9 bits of a second mix,
+ * stepped by double hashing, pick one of the
+ * block's 512 bits.
+ *******************************************/
+inline unsigned long long BloomFilter :: bitsOf(size_t h, int i, int & word)
+{
+   unsigned long long m = ((unsigned long long)h ^ ((unsigned long long)h >> 29)) *
+                          0xBF58476D1CE4E5B9ULL;
+   unsigned int h1 = (unsigned int)m;
+   unsigned int h2 = (unsigned int)(m >> 32) | 1;
+   unsigned int bit = (h1 + (unsigned int)i * h2) >> 23;
+   word = bit >> 6;
+   return 1ULL << (bit & 63);
+}
+
+/*******************************************
+ * BloomFilter :: add
+ *******************************************/
+inline void BloomFilter :: add(size_t h)
+{
+   unsigned long long * block = blocks + 8 * blockOf(h);
+   for (int i = 0; i < numProbes; i++)
+   {
+      int word;
+      unsigned long long bit = bitsOf(h, i, word);
+      block[word] |= bit;
+   }
+   numKeys++;
+}
+
+/*******************************************
+ * BloomFilter :: mayContain
+ *******************************************/
+inline bool BloomFilter :: mayContain(size_t h) const
+{
+   const unsigned long long * block = blocks + 8 * blockOf(h);
+   for (int i = 0; i < numProbes; i++)
+   {
+      int word;
+      unsigned long long bit = bitsOf(h, i, word);
+      if (!(block[word] & bit))
+      {
+         numRejected.fetch_add(1, memory_order_relaxed);
+         return false;
+      }
+   }
+   return true;
+}
+
+/*******************************************
+ * bloomHash
+ * How Set and BST hash a key for their filter.
+ * They keep a pointer to this, made with the
+ * Hash given to enableFilter(), so a T with no
+ * hash only needs one if a filter is used.
+ *******************************************/
+template <class T, class Hash>
+size_t bloomHash(const T & t)
+{
+   return Hash()(t);
+}
+
+#endif // BLOOM_H
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <cassert>
+#include <cstdint>
 
 using namespace std;
 
@@ -11,6 +12,11 @@ using namespace std;
  * A single node in a binary tree.  Note that the node does not know
  * anything about the properties of the tree so no validation can be done.
  *
+ * The red-black color a balanced tree needs rides in the low bit of the
+ * parent pointer (nodes are at least pointer aligned, so that bit is
+ * always zero in a real address).  Use parent() and setParent() rather
+ * than touching the tagged word.
+ *
  * Author: Ryan Walker
  *****************************************************************/
 template <class T>
@@ -19,26 +25,46 @@ class BinaryNode
 public:
 	// data inside nodes
    T data;
+   // how many nodes in the subtree rooted here, this one included.
+   // Only a tree that keeps it up to date (BST does) can rely on it.
+   int count;
    // left node.  Points to its own parent and potentially its own left and right nodes
    BinaryNode <T> * pLeft;
    // right node.  Points to its own parent and potentially its own left and right nodes
    BinaryNode <T> * pRight;
-   // parent node.  Points to left and right
-   BinaryNode <T> * pParent;
+   // parent node, with the color in the low bit
+   uintptr_t parentAndColor;
 
    // default constructor : empty and kinda useless
-   BinaryNode() : data(NULL), pLeft(NULL), pRight(NULL), pParent(NULL) {}
+   BinaryNode() : data(NULL), count(1), pLeft(NULL), pRight(NULL), parentAndColor(0) {}
 
    // non-default constructor : takes a template as a parameter
    // and creates a root node
    BinaryNode(T data)
    {
    	this->data = data;
+   	count   = 1;
    	pLeft   = NULL;
    	pRight  = NULL;
-   	pParent = NULL;
+   	parentAndColor = 0;
+   }
+
+   // the parent node, NULL at the root
+   BinaryNode <T> * parent() const
+   {
+      return (BinaryNode <T> *)(parentAndColor & ~(uintptr_t)1);
    }
 
+   // change the parent, keeping the color
+   void setParent(BinaryNode <T> * p)
+   {
+      parentAndColor = (uintptr_t)p | (parentAndColor & 1);
+   }
+
+   // red or black (a new node is black until a tree says otherwise)
+   bool isRed() const         { return parentAndColor & 1; }
+   void setRed(bool red)      { parentAndColor = (parentAndColor & ~(uintptr_t)1) | (red ? 1 : 0); }
+
    // return size (i.e. number of nodes in tree)
    int size() const
    {
@@ -67,7 +93,7 @@ BinaryNode <T> BinaryNode <T> :: addLeft (BinaryNode <T> * pNode)
 	pLeft = pNode;
 	if (pLeft != NULL)
 	{
-		pLeft->pParent = this;
+		pLeft->setParent(this);
 	}
 
 	return *this;
@@ -84,7 +110,7 @@ BinaryNode <T> BinaryNode <T> :: addRight(BinaryNode <T> * pNode)
 	pRight = pNode;
 	if (pRight != NULL)
 	{
-		pRight->pParent = this;
+		pRight->setParent(this);
 	}
 
 	return *this;
@@ -100,7 +126,7 @@ template <class T>
 BinaryNode <T> BinaryNode <T> :: addLeft (const T & t) throw (const char *)
 {
 	pLeft = new BinaryNode<T>(t);
-	pLeft->pParent = this;
+	pLeft->setParent(this);
 
 	return *this;
 }
@@ -115,7 +141,7 @@ template <class T>
 BinaryNode <T> BinaryNode <T> :: addRight(const T & t) throw (const char *)
 {
 	pRight = new BinaryNode<T>(t);
-	pRight->pParent = this;
+	pRight->setParent(this);
 
 	return *this;
 }
@@ -9,20 +9,35 @@
  * Contains a BinaryNode "root" that serves as the beginning of
  * the tree.  The BST automatically sorts what is inserted and
  * can find any value within.
+ *    The tree is kept red-black: no red node has a red child and
+ * every path down from a node passes the same number of black
+ * nodes, so it is never more than 2 log n deep, even when the
+ * items come in sorted.
+ *    Every node also knows how many nodes are under it, so size()
+ * is O(1) and select(), rank() and count_range() are O(log n).
+ *    Lots of items at once should go in with build_from_sorted()
+ * or insert_batch(), which lay the nodes out as a perfectly
+ * balanced tree in one O(n) pass instead of n inserts.
  ************************************************************************/
 
 #ifndef BST_H
 #define BST_H
 
+#include "bloom.h"    // for BloomFilter
 #include "bnode.h"    // for BinaryNode
-#include "stack.h"    // for Stack
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <vector>
 
 using namespace std;
 
-// forward declaration for the BST iterator
-template <class T>
-class BSTIterator; 
+// forward declarations for the BST iterators.  Reverse ones walk
+// from the largest item down.
+template <class T, bool Reverse = false>
+class BSTIterator;
+template <class T, bool Reverse = false>
+class BSTConstIterator;
 
 /*****************************************************************
  * BINARY SEARCH TREE
@@ -34,11 +49,72 @@ class BST
 {
 private:
 
+   BloomFilter * filter;   // optional, see enableFilter()
+   size_t (*filterHash)(const T &);
+
+   // build the filter again from the tree
+   void refilter() throw (const char *);
+
+   // recount a node from its children, or every node from here up
+   void pull(BinaryNode <T> * node);
+   void pullUp(BinaryNode <T> * node);
+   static int countOf(const BinaryNode <T> * node) { return node ? node->count : 0; }
+
+   // how many items are smaller than t (or no bigger, if orEqual)
+   int countBelow(const T & t, bool orEqual) const;
+
+   // red-black upkeep
+   void rotateLeft(BinaryNode <T> * node);
+   void rotateRight(BinaryNode <T> * node);
+   void insertFixup(BinaryNode <T> * node);
+   void removeFixup(BinaryNode <T> * node, BinaryNode <T> * parent);
+
+   // put "with" where "node" was under node's parent
+   void transplant(BinaryNode <T> * node, BinaryNode <T> * with);
+
+   // a copy of a subtree, colors and all
+   BinaryNode <T> * copyTree(const BinaryNode <T> * node,
+                             BinaryNode <T> * parent) throw (const char *);
+
+   // free a subtree with freeNode
+   void destroy(BinaryNode <T> * node);
+
+   // the tree's nodes in order
+   void flatten(vector<BinaryNode <T> *> & nodes) const;
+
+   // make nodes[lo, hi) a perfectly balanced subtree of parent.
+   // Nodes at redDepth are red, the rest black.
+   BinaryNode <T> * link(const vector<BinaryNode <T> *> & nodes, int lo, int hi,
+                         BinaryNode <T> * parent, int depth, int redDepth);
+
+   // make nodes, which are in order, the whole tree
+   void relink(const vector<BinaryNode <T> *> & nodes);
+
+   // NULL leaves are black
+   static bool isRed(const BinaryNode <T> * node) { return node && node->isRed(); }
+
+   // a plain BST's nodes
+   static BinaryNode <T> * makeNode(const T & t)  { return new BinaryNode <T> (t); }
+   static void dropNode(BinaryNode <T> * node)    { delete node;                   }
+
+protected:
    BinaryNode <T> * root;  // beginning of the tree
 
+   // how nodes are made, freed and summed.  AggregateBST (see
+   // aggbst.h) swaps in bigger nodes that keep a running total.
+   BinaryNode <T> * (*newNode)(const T & t);
+   void (*freeNode)(BinaryNode <T> * node);
+   void (*sumNode)(BinaryNode <T> * node);   // NULL if there is no total
+
 public:
+   typedef BSTIterator <T>             iterator;
+   typedef BSTConstIterator <T>        const_iterator;
+   typedef BSTIterator <T, true>       reverse_iterator;
+   typedef BSTConstIterator <T, true>  const_reverse_iterator;
+
    // constructor
-   BST(): root(NULL){};
+   BST(): filter(NULL), filterHash(NULL), root(NULL),
+          newNode(&makeNode), freeNode(&dropNode), sumNode(NULL) {};
    
    // copy constructor
    BST(const BST & rhs);    
@@ -47,44 +123,101 @@ public:
    ~BST();
 
    // how many nodes
-   int  size()  const { return empty() ? 0 : root->size();   }
+   int  size()  const { return countOf(root);                }
    
    // determine if the tree is empty
    bool empty() const { return root ? false : true;          }
 
    // clear all the contests of the tree
-   void clear()       { root = NULL; deleteBinaryTree(root); }
+   void clear()       { destroy(root); root = NULL; if (filter) filter->reset(0); }
 
    // overloaded assignment operator
-   BST & operator= (const BST & rhs)
+   BST & operator= (const BST & rhs) throw (const char *)
    {
-      BinaryNode<T>* tmp = rhs.root;
-      std::swap(this->root, tmp);
+      if (this != &rhs)
+      {
+         BinaryNode <T> * tmp = copyTree(rhs.root, NULL);
+         std::swap(this->root, tmp);
+         destroy(tmp);
+         refilter();
+      }
       return *this;
    }
       
    // insert an item
    void insert(const T & t) throw (const char * );
 
+   // throw out what we have and hold [first, last) instead, which
+   // must already be in order.  O(n).
+   template <class Iterator>
+   void build_from_sorted(Iterator first, Iterator last) throw (const char *);
+
+   // insert [first, last), in any order.  A batch that is big next
+   // to the tree is sorted and merged with it in O(n + m log m);
+   // a small one just goes in an item at a time.
+   template <class Iterator>
+   void insert_batch(Iterator first, Iterator last) throw (const char *);
+
    // remove an item
    void remove(BSTIterator <T> & it);
 
    // find a given item
    BSTIterator <T> find(const T & t);
 
+   // the item with k items before it (0 is the smallest), or end()
+   iterator select(int k) const;
+
+   // how many items are smaller than t
+   int rank(const T & t) const          { return countBelow(t, false); }
+
+   // how many items are in [lo, hi]
+   int count_range(const T & lo, const T & hi) const
+   {
+      return hi < lo ? 0 : countBelow(hi, true) - countBelow(lo, false);
+   }
+
+   // put a Bloom filter (see bloom.h) in front of find() so most
+   // misses skip the search.  Hash is only needed if you do this.
+   template <class Hash = hash<T> >
+   void enableFilter(int bitsPerKey = 10) throw (const char *);
+
+   // take it away again
+   void disableFilter()   { delete filter; filter = NULL; }
+
+   // of the finds that missed, the fraction the filter let through
+   double filterFalsePositiveRate() const
+   {
+      return filter ? filter->falsePositiveRate() : 0.0;
+   }
+
    // the usual iterator stuff
-   BSTIterator <T> begin() const;
-   BSTIterator <T> end() const  { return BSTIterator <T> (NULL) ; }
-   BSTIterator <T> rbegin() const;
-   BSTIterator <T> rend() const  { return BSTIterator <T> (NULL); }
+   iterator begin() const                 { return iterator(leftmost());          }
+   iterator end() const                   { return iterator(NULL);                }
+   const_iterator cbegin() const          { return const_iterator(leftmost());    }
+   const_iterator cend() const            { return const_iterator(NULL);          }
+   reverse_iterator rbegin() const        { return reverse_iterator(rightmost()); }
+   reverse_iterator rend() const          { return reverse_iterator(NULL);        }
+   const_reverse_iterator crbegin() const { return const_reverse_iterator(rightmost()); }
+   const_reverse_iterator crend() const   { return const_reverse_iterator(NULL);  }
+
+private:
+   // the smallest and largest nodes
+   BinaryNode <T> * leftmost() const;
+   BinaryNode <T> * rightmost() const;
 };
 
 /*********************************************************
 * copy constructor
 **********************************************************/
 template <class T>
-BST<T>::BST(const BST &rhs)
+BST<T>::BST(const BST &rhs) : filter(NULL), filterHash(NULL), root(NULL),
+   newNode(rhs.newNode), freeNode(rhs.freeNode), sumNode(rhs.sumNode)
 {
+   if (rhs.filter)
+   {
+      filter = new BloomFilter(*rhs.filter);
+      filterHash = rhs.filterHash;
+   }
    *this = rhs;
 }
 
@@ -94,54 +227,48 @@ BST<T>::BST(const BST &rhs)
 template <class T>
 BST<T>::~BST()
 {
-   deleteBinaryTree(root);
+   destroy(root);
    root = NULL;
+   delete filter;
 }
 
 
 /*****************************************************
- * BST :: BEGIN
- * Return the first node (left-most) in a binary search tree
+ * BST :: LEFTMOST
+ * The first node in a binary search tree
  ****************************************************/
 template <class T>
-BSTIterator <T> BST <T> :: begin() const
+BinaryNode <T> * BST <T> :: leftmost() const
 {
-   Stack < BinaryNode <T> * > nodes;
-
-   nodes.push(NULL);
-   nodes.push(root);
-   while (nodes.top() != NULL && nodes.top()->pLeft)
-      nodes.push(nodes.top()->pLeft);
-
-   return BSTIterator<T>(nodes);   
+   BinaryNode <T> * node = root;
+   while (node && node->pLeft)
+      node = node->pLeft;
+   return node;
 }
 
 /*****************************************************
- * BST :: RBEGIN
- * Return the last node (right-most) in a binary search tree
+ * BST :: RIGHTMOST
+ * The last node in a binary search tree
  ****************************************************/
 template <class T>
-BSTIterator <T> BST <T> :: rbegin() const
+BinaryNode <T> * BST <T> :: rightmost() const
 {
-   Stack < BinaryNode <T> * > nodes;
-
-   nodes.push(NULL);
-   nodes.push(root);
-   while (nodes.top() != NULL && nodes.top()->pRight)
-      nodes.push(nodes.top()->pRight);
-
-   return BSTIterator<T>(nodes);
+   BinaryNode <T> * node = root;
+   while (node && node->pRight)
+      node = node->pRight;
+   return node;
 }
 
 /*****************************************************
  * BST :: INSERT
- * Insert a node at a given location in the tree
+ * Insert a node at a given location in the tree, red,
+ * then fix any red-red it made on the way back up
  ****************************************************/
 template <class T>
 void BST <T> :: insert(const T & t) throw (const char *)
 {
 	BinaryNode <T> * ptr = root;
-	BinaryNode <T> * parent = root;
+	BinaryNode <T> * parent = NULL;
 
    try
    {
@@ -152,13 +279,13 @@ void BST <T> :: insert(const T & t) throw (const char *)
    		{
    			ptr = ptr->pLeft;
    		}
-   		else if (t > ptr->data)
+   		else
    		{
    			ptr = ptr->pRight;
    		}
    	}
 
-   	ptr = new BinaryNode<T>(t);
+   	ptr = newNode(t);
    	if (parent == NULL)
    	{
    		root = ptr;
@@ -166,13 +293,24 @@ void BST <T> :: insert(const T & t) throw (const char *)
    	else if (t <= parent->data)
    	{
    		parent->pLeft = ptr;
-         ptr->pParent = parent;
+         ptr->setParent(parent);
    	}
    	else
    	{
    		parent->pRight = ptr;
-         ptr->pParent = parent;
+         ptr->setParent(parent);
    	}
+      pullUp(parent);
+
+      ptr->setRed(true);
+      insertFixup(ptr);
+
+      if (filter)
+      {
+         filter->add(filterHash(t));
+         if (filter->stale())
+            refilter();
+      }
    }
    catch(std::bad_alloc)
    {
@@ -182,88 +320,546 @@ void BST <T> :: insert(const T & t) throw (const char *)
 
 /*************************************************
  * BST :: REMOVE
- * Remove a given node as specified by the iterator
+ * Remove a given node as specified by the iterator.
+ * A node with two children trades places with its
+ * successor, which has at most one.  If a black
+ * node came out of the tree, removeFixup puts the
+ * missing black back.
  ************************************************/
 template <class T>
 void BST <T> :: remove(BSTIterator <T> & it)
 {
 	BinaryNode <T> * node = it.getNode();
-
-   BSTIterator <T> found;
-   found = find(node->data);
-   if (found == end())
+   if (node == NULL)
       return; // it's not found so it can't be removed
 
-	if (node->pLeft && node->pRight) // has two children to reroute
+   BinaryNode <T> * child;        // what moves into the hole
+   BinaryNode <T> * childParent;  // where, since child may be NULL
+   bool removedBlack = !node->isRed();
+
+	if (node->pLeft == NULL)
 	{
-		BinaryNode <T> * ptr = node->pRight;
-
-		if (ptr->pLeft)
-		{
-			while (ptr->pLeft != NULL)
-			{
-				ptr = ptr->pLeft;
-			}
-
-			if (ptr->pRight)
-			{
-				ptr->pRight->pParent = ptr->pParent;
-				ptr->pParent->pLeft = ptr->pRight;
-			}
-			node->data = ptr->data;
-		}
-		else
-		{
-			node->data = ptr->data;
-			node->pRight = ptr->pRight;
-			ptr->pRight->pParent = node;
-		}
-
-		delete ptr;
+      child = node->pRight;
+      childParent = node->parent();
+      transplant(node, node->pRight);
 	}
-	else if (node->pLeft && node->pRight == NULL) // has a left child to reroute
+	else if (node->pRight == NULL)
 	{
-		node->pLeft->pParent = node->pParent;
-		if (node->pParent->pLeft == node)
-		{
-			node->pParent->pLeft = node->pLeft;
-		}
-		else if (node->pParent->pRight == node)
-		{
-			node->pParent->pRight = node->pLeft;
-		}
-
-		delete node;
+      child = node->pLeft;
+      childParent = node->parent();
+      transplant(node, node->pLeft);
 	}
-	else if (node->pRight && node->pLeft == NULL) // has a right child to reroute
+	else // has two children to reroute
 	{
-		node->pRight->pParent = node->pParent;
-		if (node->pParent->pLeft == node)
-		{
-			node->pParent->pLeft = node->pRight;
-		}
-		else if (node->pParent->pRight == node)
-		{
-			node->pParent->pRight = node->pRight;
-		}
-		
-		delete node;
+		BinaryNode <T> * next = node->pRight;
+		while (next->pLeft != NULL)
+			next = next->pLeft;
+
+      removedBlack = !next->isRed();
+      child = next->pRight;
+      if (next->parent() == node)
+         childParent = next;
+      else
+      {
+         childParent = next->parent();
+         transplant(next, next->pRight);
+         next->pRight = node->pRight;
+         next->pRight->setParent(next);
+      }
+
+      transplant(node, next);
+      next->pLeft = node->pLeft;
+      next->pLeft->setParent(next);
+      next->setRed(node->isRed());
 	}
-	else if (node->pRight == NULL && node->pLeft == NULL) // doesn't have any children to reroute
+
+   pullUp(childParent);
+   freeNode(node);
+   if (removedBlack)
+      removeFixup(child, childParent);
+
+	if (filter)
 	{
-		if (node->pParent->pLeft == node)
-		{
-			node->pParent->pLeft = NULL;
-		}
-		else if (node->pParent->pRight == node)
-		{
-			node->pParent->pRight = NULL;
-		}
-		
-		delete node;
+		filter->erased();
+		if (filter->stale())
+			refilter();
 	}
 }
 
+/*************************************************
+ * BST :: TRANSPLANT
+ ************************************************/
+template <class T>
+void BST <T> :: transplant(BinaryNode <T> * node, BinaryNode <T> * with)
+{
+   BinaryNode <T> * parent = node->parent();
+   if (parent == NULL)
+      root = with;
+   else if (node == parent->pLeft)
+      parent->pLeft = with;
+   else
+      parent->pRight = with;
+
+   if (with)
+      with->setParent(parent);
+}
+
+/*************************************************
+ * BST :: ROTATE LEFT
+ * node's right child takes its place, and node
+ * becomes that child's left
+ ************************************************/
+template <class T>
+void BST <T> :: rotateLeft(BinaryNode <T> * node)
+{
+   BinaryNode <T> * right = node->pRight;
+   node->pRight = right->pLeft;
+   if (right->pLeft)
+      right->pLeft->setParent(node);
+
+   transplant(node, right);
+   right->pLeft = node;
+   node->setParent(right);
+
+   pull(node);
+   pull(right);
+}
+
+/*************************************************
+ * BST :: ROTATE RIGHT
+ * the mirror image
+ ************************************************/
+template <class T>
+void BST <T> :: rotateRight(BinaryNode <T> * node)
+{
+   BinaryNode <T> * left = node->pLeft;
+   node->pLeft = left->pRight;
+   if (left->pRight)
+      left->pRight->setParent(node);
+
+   transplant(node, left);
+   left->pRight = node;
+   node->setParent(left);
+
+   pull(node);
+   pull(left);
+}
+
+/*************************************************
+ * BST :: INSERT FIXUP
+ * A red uncle means recolor and carry the problem
+ * two levels up.  A black uncle means one or two
+ * rotations and we are done.
+ ************************************************/
+template <class T>
+void BST <T> :: insertFixup(BinaryNode <T> * node)
+{
+   while (isRed(node->parent()))
+   {
+      BinaryNode <T> * parent = node->parent();
+      BinaryNode <T> * grand = parent->parent();   // a red node is never the root
+
+      if (parent == grand->pLeft)
+      {
+         BinaryNode <T> * uncle = grand->pRight;
+         if (isRed(uncle))
+         {
+            parent->setRed(false);
+            uncle->setRed(false);
+            grand->setRed(true);
+            node = grand;
+            continue;
+         }
+         if (node == parent->pRight)
+         {
+            rotateLeft(parent);
+            node = parent;
+            parent = node->parent();
+         }
+         parent->setRed(false);
+         grand->setRed(true);
+         rotateRight(grand);
+      }
+      else
+      {
+         BinaryNode <T> * uncle = grand->pLeft;
+         if (isRed(uncle))
+         {
+            parent->setRed(false);
+            uncle->setRed(false);
+            grand->setRed(true);
+            node = grand;
+            continue;
+         }
+         if (node == parent->pLeft)
+         {
+            rotateRight(parent);
+            node = parent;
+            parent = node->parent();
+         }
+         parent->setRed(false);
+         grand->setRed(true);
+         rotateLeft(grand);
+      }
+   }
+   root->setRed(false);
+}
+
+/*************************************************
+ * BST :: REMOVE FIXUP
+ * node (maybe NULL, hence parent) is short one
+ * black.  Borrow from the sibling's side with
+ * recoloring and rotations, or push the shortage
+ * up a level and try again.
+ ************************************************/
+template <class T>
+void BST <T> :: removeFixup(BinaryNode <T> * node, BinaryNode <T> * parent)
+{
+   while (node != root && !isRed(node))
+   {
+      if (node == parent->pLeft)
+      {
+         BinaryNode <T> * sibling = parent->pRight;
+         if (isRed(sibling))
+         {
+            sibling->setRed(false);
+            parent->setRed(true);
+            rotateLeft(parent);
+            sibling = parent->pRight;
+         }
+         if (!isRed(sibling->pLeft) && !isRed(sibling->pRight))
+         {
+            sibling->setRed(true);
+            node = parent;
+            parent = node->parent();
+            continue;
+         }
+         if (!isRed(sibling->pRight))
+         {
+            sibling->pLeft->setRed(false);
+            sibling->setRed(true);
+            rotateRight(sibling);
+            sibling = parent->pRight;
+         }
+         sibling->setRed(parent->isRed());
+         parent->setRed(false);
+         sibling->pRight->setRed(false);
+         rotateLeft(parent);
+      }
+      else
+      {
+         BinaryNode <T> * sibling = parent->pLeft;
+         if (isRed(sibling))
+         {
+            sibling->setRed(false);
+            parent->setRed(true);
+            rotateRight(parent);
+            sibling = parent->pLeft;
+         }
+         if (!isRed(sibling->pLeft) && !isRed(sibling->pRight))
+         {
+            sibling->setRed(true);
+            node = parent;
+            parent = node->parent();
+            continue;
+         }
+         if (!isRed(sibling->pLeft))
+         {
+            sibling->pRight->setRed(false);
+            sibling->setRed(true);
+            rotateLeft(sibling);
+            sibling = parent->pLeft;
+         }
+         sibling->setRed(parent->isRed());
+         parent->setRed(false);
+         sibling->pLeft->setRed(false);
+         rotateRight(parent);
+      }
+      node = root;
+   }
+
+   if (node)
+      node->setRed(false);
+}
+
+/*************************************************
+ * BST :: COPY TREE
+ * The tree is balanced, so recursion is only
+ * O(log n) deep
+ ************************************************/
+template <class T>
+BinaryNode <T> * BST <T> :: copyTree(const BinaryNode <T> * node,
+                                     BinaryNode <T> * parent) throw (const char *)
+{
+   if (node == NULL)
+      return NULL;
+
+   BinaryNode <T> * copy;
+   try
+   {
+      copy = newNode(node->data);
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+   copy->setParent(parent);
+   copy->setRed(node->isRed());
+
+   try
+   {
+      copy->pLeft = copyTree(node->pLeft, copy);
+      copy->pRight = copyTree(node->pRight, copy);
+   }
+   catch (const char * error)
+   {
+      destroy(copy);
+      throw;
+   }
+   pull(copy);
+   return copy;
+}
+
+/*************************************************
+ * BST :: DESTROY
+ ************************************************/
+template <class T>
+void BST <T> :: destroy(BinaryNode <T> * node)
+{
+   if (node == NULL)
+      return;
+   destroy(node->pLeft);
+   destroy(node->pRight);
+   freeNode(node);
+}
+
+/*************************************************
+ * BST :: FLATTEN
+ ************************************************/
+template <class T>
+void BST <T> :: flatten(vector<BinaryNode <T> *> & nodes) const
+{
+   for (BinaryNode <T> * node = leftmost(); node; node = bstStep(node, true))
+      nodes.push_back(node);
+}
+
+/*************************************************
+ * BST :: LINK
+ * The middle node is the root, and each half is
+ * built the same way.  The halves never differ by
+ * more than one node, so every NULL is on one of
+ * the last two levels.  Coloring the last level
+ * red (and nothing else) gives every path the
+ * same number of black nodes.
+ ************************************************/
+template <class T>
+BinaryNode <T> * BST <T> :: link(const vector<BinaryNode <T> *> & nodes,
+                                 int lo, int hi, BinaryNode <T> * parent,
+                                 int depth, int redDepth)
+{
+   if (lo >= hi)
+      return NULL;
+
+   int mid = lo + (hi - lo) / 2;
+   BinaryNode <T> * node = nodes[mid];
+   node->parentAndColor = 0;
+   node->setParent(parent);
+   node->setRed(depth == redDepth);
+   node->pLeft = link(nodes, lo, mid, node, depth + 1, redDepth);
+   node->pRight = link(nodes, mid + 1, hi, node, depth + 1, redDepth);
+   pull(node);
+   return node;
+}
+
+/*************************************************
+ * BST :: RELINK
+ * The last level is the first one that can't be
+ * full: floor(log2(n + 1))
+ ************************************************/
+template <class T>
+void BST <T> :: relink(const vector<BinaryNode <T> *> & nodes)
+{
+   int n = (int)nodes.size();
+   int redDepth = 0;
+   while ((2LL << redDepth) - 1 <= n)
+      redDepth++;
+   root = link(nodes, 0, n, NULL, 0, redDepth);
+}
+
+/*************************************************
+ * BST :: PULL
+ * node's count (and total, if any) from its
+ * children's, which must already be right
+ ************************************************/
+template <class T>
+void BST <T> :: pull(BinaryNode <T> * node)
+{
+   node->count = 1 + countOf(node->pLeft) + countOf(node->pRight);
+   if (sumNode)
+      sumNode(node);
+}
+
+/*************************************************
+ * BST :: PULL UP
+ * After a node comes or goes, everything above
+ * it has changed
+ ************************************************/
+template <class T>
+void BST <T> :: pullUp(BinaryNode <T> * node)
+{
+   for (; node; node = node->parent())
+      pull(node);
+}
+
+/****************************************************
+ * BST :: BUILD FROM SORTED
+ * Make all the nodes first, so if we run out of
+ * memory the tree is still what it was
+ ****************************************************/
+template <class T>
+template <class Iterator>
+void BST <T> :: build_from_sorted(Iterator first, Iterator last) throw (const char *)
+{
+   vector<BinaryNode <T> *> nodes;
+   try
+   {
+      for (; first != last; ++first)
+      {
+         assert(nodes.empty() || !(*first < nodes.back()->data));
+         nodes.push_back(NULL);            // room first, so no node leaks
+         nodes.back() = newNode(*first);
+      }
+   }
+   catch (std::bad_alloc)
+   {
+      for (int i = 0; i < (int)nodes.size(); i++)
+         if (nodes[i])
+            freeNode(nodes[i]);
+      throw "ERROR: Unable to allocate a node";
+   }
+
+   destroy(root);
+   relink(nodes);
+   refilter();
+}
+
+/****************************************************
+ * BST :: INSERT BATCH
+ * m inserts cost about m log(n + m).  Merging costs
+ * n + m, and reuses the nodes we already have.
+ ****************************************************/
+template <class T>
+template <class Iterator>
+void BST <T> :: insert_batch(Iterator first, Iterator last) throw (const char *)
+{
+   vector<T> batch;
+   try
+   {
+      batch.assign(first, last);
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate buffer";
+   }
+
+   int n = size();
+   int m = (int)batch.size();
+   int logSize = 1;
+   while ((1LL << logSize) < (long long)n + m)
+      logSize++;
+
+   if ((long long)m * logSize < (long long)n + m)
+   {
+      for (int i = 0; i < m; i++)
+         insert(batch[i]);
+      return;
+   }
+
+   std::sort(batch.begin(), batch.end());
+
+   vector<BinaryNode <T> *> old;
+   vector<BinaryNode <T> *> fresh;
+   vector<BinaryNode <T> *> merged;
+   try
+   {
+      old.reserve(n);
+      fresh.reserve(m);
+      merged.reserve(n + m);
+      for (int i = 0; i < m; i++)
+         fresh.push_back(newNode(batch[i]));
+   }
+   catch (std::bad_alloc)
+   {
+      for (int i = 0; i < (int)fresh.size(); i++)
+         freeNode(fresh[i]);
+      throw "ERROR: Unable to allocate a node";
+   }
+
+   flatten(old);
+   int i = 0;
+   int j = 0;
+   while (i < n || j < m)
+   {
+      if (j < m && (i == n || fresh[j]->data < old[i]->data))
+         merged.push_back(fresh[j++]);
+      else
+         merged.push_back(old[i++]);
+   }
+
+   relink(merged);
+   refilter();
+}
+
+/****************************************************
+ * BST :: SELECT
+ * Skip whole left subtrees by their counts
+ ****************************************************/
+template <class T>
+BSTIterator <T> BST <T> :: select(int k) const
+{
+   BinaryNode <T> * node = root;
+   if (k < 0)
+      return end();
+
+   while (node)
+   {
+      int left = countOf(node->pLeft);
+      if (k < left)
+         node = node->pLeft;
+      else if (k == left)
+         break;
+      else
+      {
+         k -= left + 1;
+         node = node->pRight;
+      }
+   }
+   return iterator(node);
+}
+
+/****************************************************
+ * BST :: COUNT BELOW
+ * Every time we go right, the node and its left
+ * subtree are all below t
+ ****************************************************/
+template <class T>
+int BST <T> :: countBelow(const T & t, bool orEqual) const
+{
+   int below = 0;
+   const BinaryNode <T> * node = root;
+   while (node)
+   {
+      if (node->data < t || (orEqual && !(t < node->data)))
+      {
+         below += countOf(node->pLeft) + 1;
+         node = node->pRight;
+      }
+      else
+         node = node->pLeft;
+   }
+   return below;
+}
+
 /****************************************************
  * BST :: FIND
  * Return the node corresponding to a given value
@@ -271,6 +867,9 @@ void BST <T> :: remove(BSTIterator <T> & it)
 template <class T>
 BSTIterator <T> BST <T> :: find(const T & t)
 {
+	if (filter && !filter->mayContain(filterHash(t)))
+		return end(); // certainly not here
+
 	BinaryNode <T> * ptr = root;
 	bool found = false;
 
@@ -289,170 +888,195 @@ BSTIterator <T> BST <T> :: find(const T & t)
    		found = true;
    	}
    }
-   
-	Stack <BinaryNode <T> *> stack;
-	stack.push(ptr);
 
-	return BSTIterator<T>(stack);
+   if (filter && ptr == NULL)
+      filter->falsePositive();
+
+	return BSTIterator<T>(ptr);
 }
 
-/**********************************************************
- * BINARY SEARCH TREE ITERATOR
- * Forward and reverse iterator through a BST
- *********************************************************/
+/****************************************************
+ * BST :: ENABLE FILTER
+ * Replace any filter we had with a new one with
+ * bitsPerKey bits for each key
+ ****************************************************/
 template <class T>
-class BSTIterator
+template <class Hash>
+void BST <T> :: enableFilter(int bitsPerKey) throw (const char *)
 {
-public:
-   // constructors
-   BSTIterator(BinaryNode <T> * p = NULL)    { nodes.push(p);     }
-   BSTIterator(Stack <BinaryNode <T> *> & s) { nodes = s;         }
-   BSTIterator(const BSTIterator <T> & rhs)  { nodes = rhs.nodes; }
-
-   // assignment
-   BSTIterator <T> & operator = (const BSTIterator <T> & rhs)
+   BloomFilter * nFilter;
+   try
    {
-      // need an assignment operator for the Stack class.
-      nodes = rhs.nodes;
-      return *this;
+      nFilter = new BloomFilter(bitsPerKey);
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate filter";
    }
 
-   // compare
-   bool operator == (const BSTIterator <T> & rhs) const
+   delete filter;
+   filter = nFilter;
+   filterHash = &bloomHash<T, Hash>;
+   refilter();
+}
+
+/****************************************************
+ * BST :: REFILTER
+ * Sized for twice what we have now so growing
+ * doesn't rebuild it again right away
+ ****************************************************/
+template <class T>
+void BST <T> :: refilter() throw (const char *)
+{
+   if (!filter)
+      return;
+
+   filter->reset(2 * size());
+   for (BSTIterator <T> it = begin(); it != end(); ++it)
+      filter->add(filterHash(*it));
+}
+
+/**********************************************************
+ * BST STEP
+ * The next node in order (forward) or the one before it.
+ * Either go down one side and then all the way down the
+ * other, or climb until we come up from the other side.
+ * Over a whole walk each edge is crossed twice, so this is
+ * O(1) amortized.
+ *********************************************************/
+template <class T>
+BinaryNode <T> * bstStep(BinaryNode <T> * node, bool forward)
+{
+   BinaryNode <T> * down = forward ? node->pRight : node->pLeft;
+   if (down)
    {
-      // only need to compare the leaf node 
-      return rhs.nodes.const_top() == nodes.const_top();
+      BinaryNode <T> * next;
+      while ((next = forward ? down->pLeft : down->pRight) != NULL)
+         down = next;
+      return down;
    }
-   bool operator != (const BSTIterator <T> & rhs) const
+
+   BinaryNode <T> * parent = node->parent();
+   while (parent && node == (forward ? parent->pRight : parent->pLeft))
    {
-      // only need to compare the leaf node 
-      return rhs.nodes.const_top() != nodes.const_top();
+      node = parent;
+      parent = parent->parent();
    }
+   return parent;
+}
+
+/**********************************************************
+ * BINARY SEARCH TREE ITERATOR
+ * Forward or reverse iterator through a BST.  It is just
+ * the node, and walks with the parent pointers.
+ *********************************************************/
+template <class T, bool Reverse>
+class BSTIterator
+{
+public:
+   // constructors
+   BSTIterator(BinaryNode <T> * p = NULL) : p(p) {}
 
-   // de-reference. Cannot change because it will invalidate the BST
-   T & operator * ()  
+   // compare
+   bool operator == (const BSTIterator & rhs) const { return p == rhs.p; }
+   bool operator != (const BSTIterator & rhs) const { return p != rhs.p; }
+
+   // de-reference.  Changing the item can put it out of order
+   T & operator * () const
    {
-      return nodes.top()->data;
+      return p->data;
    }
 
    // iterators
-   BSTIterator <T> & operator ++ ();
-   BSTIterator <T>   operator ++ (int postfix)
+   BSTIterator & operator ++ ()
+   {
+      if (p)
+         p = bstStep(p, !Reverse);
+      return *this;
+   }
+   BSTIterator   operator ++ (int postfix)
    {
-      BSTIterator <T> itReturn = *this;
+      BSTIterator itReturn = *this;
       ++(*this);
       return itReturn;
    }
-   BSTIterator <T> & operator -- ();
-   BSTIterator <T>   operator -- (int postfix)
+   BSTIterator & operator -- ()
    {
-      BSTIterator <T> itReturn = *this;
+      if (p)
+         p = bstStep(p, Reverse);
+      return *this;
+   }
+   BSTIterator   operator -- (int postfix)
+   {
+      BSTIterator itReturn = *this;
       --(*this);
       return itReturn;
    }
 
    // must give friend status to remove so it can call getNode() from it
    friend void BST <T> :: remove(BSTIterator <T> & it);
+   friend class BSTConstIterator <T, Reverse>;
 
 private:
    
    // get the node pointer
-   BinaryNode <T> * getNode() { return nodes.top(); }
+   BinaryNode <T> * getNode() const { return p; }
    
-   // the stack of nodes
-   Stack < BinaryNode <T> * > nodes;
+   // where we are, NULL at the end
+   BinaryNode <T> * p;
 };
 
-
-/**************************************************
- * BST ITERATOR :: INCREMENT PREFIX
- * advance by one
- *************************************************/
-template <class T>
-BSTIterator <T> & BSTIterator <T> :: operator ++ ()
+/**********************************************************
+ * BINARY SEARCH TREE CONST ITERATOR
+ * The same, but the items are read-only
+ *********************************************************/
+template <class T, bool Reverse>
+class BSTConstIterator
 {
-   // do nothing if we have nothing
-   if (nodes.top() == NULL)
-      return *this;
-   
-   // if there is a right node, take it
-   if (nodes.top()->pRight != NULL)
-   {
-      nodes.push(nodes.top()->pRight);
-
-      // there might be more left-most children
-      while (nodes.top()->pLeft)
-         nodes.push(nodes.top()->pLeft);
-      return *this;
-   }
-
-   // there are no right children, the left are done
-   assert(nodes.top()->pRight == NULL);
-   BinaryNode <T> * pSave = nodes.top();
-   nodes.pop();
-
-   // if the parent is the NULL, we are done!
-   if (NULL == nodes.top())
-      return *this;
+public:
+   // constructors
+   BSTConstIterator(const BinaryNode <T> * p = NULL) : p(p) {}
+   BSTConstIterator(const BSTIterator <T, Reverse> & rhs) : p(rhs.p) {}
 
-   // if we are the left-child, got to the parent.
-   if (pSave == nodes.top()->pLeft)
-      return *this;
+   // compare
+   bool operator == (const BSTConstIterator & rhs) const { return p == rhs.p; }
+   bool operator != (const BSTConstIterator & rhs) const { return p != rhs.p; }
 
-   // we are the right-child, go up as long as we are the right child!
-   while (nodes.top() != NULL && pSave == nodes.top()->pRight)
+   // de-reference
+   const T & operator * () const
    {
-      pSave = nodes.top();
-      nodes.pop();
+      return p->data;
    }
-      
-   return *this;      
-}
 
-/**************************************************
- * BST ITERATOR :: DECREMENT PREFIX
- * advance by one
- *************************************************/
-template <class T>
-BSTIterator <T> & BSTIterator <T> :: operator -- ()
-{
-   // do nothing if we have nothing
-   if (nodes.top() == NULL)
-      return *this;
-
-   // if there is a left node, take it
-   if (nodes.top()->pLeft != NULL)
+   // iterators
+   BSTConstIterator & operator ++ ()
    {
-      nodes.push(nodes.top()->pLeft);
-
-      // there might be more right-most children
-      while (nodes.top()->pRight)
-         nodes.push(nodes.top()->pRight);
+      if (p)
+         p = bstStep(const_cast <BinaryNode <T> *> (p), !Reverse);
       return *this;
    }
-
-   // there are no left children, the right are done
-   assert(nodes.top()->pLeft == NULL);
-   BinaryNode <T> * pSave = nodes.top();
-   nodes.pop();
-
-   // if the parent is the NULL, we are done!
-   if (NULL == nodes.top())
-      return *this;
-
-   // if we are the right-child, got to the parent.
-   if (pSave == nodes.top()->pRight)
+   BSTConstIterator   operator ++ (int postfix)
+   {
+      BSTConstIterator itReturn = *this;
+      ++(*this);
+      return itReturn;
+   }
+   BSTConstIterator & operator -- ()
+   {
+      if (p)
+         p = bstStep(const_cast <BinaryNode <T> *> (p), Reverse);
       return *this;
-
-   // we are the left-child, go up as long as we are the left child!
-   while (nodes.top() != NULL && pSave == nodes.top()->pLeft)
+   }
+   BSTConstIterator   operator -- (int postfix)
    {
-      pSave = nodes.top();
-      nodes.pop();
+      BSTConstIterator itReturn = *this;
+      --(*this);
+      return itReturn;
    }
 
-   return *this;
-}
+private:
+   const BinaryNode <T> * p;
+};
 
 
 #endif // BST_H
@@ -0,0 +1,898 @@
+/***************************************************************
+ * File: concurrentbst.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the ConcurrentBST class.
+ *    An ordered set that many threads can search, insert into
+ * and erase from at once.  It is the optimistic AVL tree of
+ * Bronson, Casper, Chafi and Olukotun ("A Practical Concurrent
+ * Binary Search Tree").
+ *
+ *    Searches take no locks and write nothing.  Each node has a
+ * version number.  A reader notes a node's version before going
+ * down to a child, and checks it again after reading the child's
+ * link.  A rotation that moves keys out from under a node marks
+ * the node "shrinking" while it works and bumps the version when
+ * it is done, so a reader that raced it sees the change and backs
+ * up one level, not all the way to the root.
+ *
+ *    Writers lock only the nodes they change, always parent
+ * before child.  An erased key with two children stays in the
+ * tree as a routing node (present is false), which is much less
+ * work than finding its successor.  A routing node is unlinked
+ * once it is down to one child.  Balance is relaxed: heights are
+ * fixed on the way back up after each change, and a thread that
+ * finds a node out of balance rotates it right there.  Unlinked
+ * nodes go to Epoch::retire(), so a reader still holding one is
+ * safe.
+ ***************************************************************/
+#ifndef CONCURRENTBST_H
+#define CONCURRENTBST_H
+
+#include "epoch.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+/************************************************
+ * ConcurrentBSTNode
+ * The links, height and present flag may be read
+ * by anyone at any time, but are only written
+ * with lock held.  data never changes.
+ ***********************************************/
+template <class T>
+class ConcurrentBSTNode
+{
+public:
+   // the version: the low bit says unlinked, the next bit says a
+   // rotation is moving things out from under us right now
+   static const unsigned long UNLINKED = 1;
+   static const unsigned long SHRINKING = 2;
+   static const unsigned long SHRINK_COUNT = 4;
+
+   T data;
+   atomic<bool> present;              // false for a routing node
+   atomic<int> height;
+   atomic<unsigned long> version;
+   atomic<ConcurrentBSTNode *> parent;
+   atomic<ConcurrentBSTNode *> left;
+   atomic<ConcurrentBSTNode *> right;
+   mutex lock;
+
+   ConcurrentBSTNode(const T & data, ConcurrentBSTNode * parent)
+      : data(data), present(true), height(1), version(0), parent(parent),
+        left(NULL), right(NULL) {}
+
+   // dir < 0 is left, dir > 0 is right
+   ConcurrentBSTNode * child(int dir) const { return dir < 0 ? left.load() : right.load(); }
+   void setChild(int dir, ConcurrentBSTNode * node)
+   {
+      if (dir < 0)
+         left.store(node);
+      else
+         right.store(node);
+   }
+
+   // a rotation brackets its work with these
+   static unsigned long beginChange(unsigned long v) { return v | SHRINKING; }
+   static unsigned long endChange(unsigned long v)   { return (v & ~SHRINKING) + SHRINK_COUNT; }
+};
+
+/************************************************
+ * ConcurrentBST
+ * insert, erase and contains are O(log n) once
+ * the rebalancing has caught up.  contains()
+ * never blocks unless it runs into a rotation.
+ ***********************************************/
+template <class T>
+class ConcurrentBST
+{
+public:
+   // default constructor : the root hangs off the right of holder
+   ConcurrentBST() : count(0) { holder = new Node(T(), NULL); }
+
+   // destructor : no other thread may be using the tree
+   ~ConcurrentBST();
+
+   // add t if it is not already there
+   bool insert(const T & t);
+
+   // remove t if it is there
+   bool erase(const T & t);
+
+   // is t there?
+   bool contains(const T & t) const;
+
+   // how many items, give or take the operations in flight
+   long size() const    { return count.load(memory_order_relaxed); }
+   bool empty() const   { return size() == 0; }
+
+private:
+   typedef ConcurrentBSTNode <T> Node;
+
+   // what an attempt found.  RETRY means a node it was relying on
+   // changed, and its caller should look again.
+   enum Result { NO, YES, RETRY };
+
+   // what nodeCondition() asks for, other than a new height
+   enum { UNLINK_REQUIRED = -1, REBALANCE_REQUIRED = -2, NOTHING_REQUIRED = -3 };
+
+   static int compare(const T & a, const T & b) { return a < b ? -1 : (b < a ? 1 : 0); }
+   static int heightOf(const Node * node)       { return node ? node->height.load() : 0; }
+
+   // the walks down from node's dir child, node having been at nodeV
+   Result attemptGet(const T & t, Node * node, int dir, unsigned long nodeV) const;
+   Result attemptInsert(const T & t, Node * node, int dir, unsigned long nodeV);
+   Result attemptErase(const T & t, Node * node, int dir, unsigned long nodeV);
+
+   // the changes at the bottom of those walks
+   Result attemptAttach(const T & t, Node * node, int dir, unsigned long nodeV);
+   Result attemptRevive(Node * node);
+   Result attemptRemove(Node * parent, Node * node);
+
+   // wait out a rotation at node
+   static void waitUntilNotChanging(Node * node);
+
+   // rebalancing.  The _nl ones expect the caller to hold the locks
+   // on the nodes passed in; each gives back the next node to fix.
+   static int nodeCondition(Node * node);
+   void fixHeightAndRebalance(Node * node);
+   static Node * fixHeight_nl(Node * node);
+   Node * rebalance_nl(Node * parent, Node * node);
+   Node * rebalanceToRight_nl(Node * parent, Node * node, Node * left, int hR0);
+   Node * rebalanceToLeft_nl(Node * parent, Node * node, Node * right, int hL0);
+   static Node * rotateRight_nl(Node * parent, Node * node, Node * nL, int hR,
+                                int hLL, Node * nLR, int hLR);
+   static Node * rotateLeft_nl(Node * parent, Node * node, int hL, Node * nR,
+                               Node * nRL, int hRL, int hRR);
+   static Node * rotateRightOverLeft_nl(Node * parent, Node * node, Node * nL, int hR,
+                                        int hLL, Node * nLR, int hLRL);
+   static Node * rotateLeftOverRight_nl(Node * parent, Node * node, int hL, Node * nR,
+                                        Node * nRL, int hRR, int hRLR);
+   static bool attemptUnlink_nl(Node * parent, Node * node);
+
+   // no copying
+   ConcurrentBST(const ConcurrentBST & rhs);
+   ConcurrentBST & operator = (const ConcurrentBST & rhs);
+
+   Node * holder;        // never moves, its version is always 0
+   atomic<long> count;
+};
+
+/*******************************************
+ * ConcurrentBST :: DESTRUCTOR
+ * Rebalancing may still be behind, so no
+ * recursion
+ *******************************************/
+template <class T>
+ConcurrentBST <T> :: ~ConcurrentBST()
+{
+   vector<Node *> todo(1, holder);
+   while (!todo.empty())
+   {
+      Node * node = todo.back();
+      todo.pop_back();
+      if (node->left.load())
+         todo.push_back(node->left.load());
+      if (node->right.load())
+         todo.push_back(node->right.load());
+      delete node;
+   }
+}
+
+/*******************************************
+ * ConcurrentBST :: contains
+ *******************************************/
+template <class T>
+bool ConcurrentBST <T> :: contains(const T & t) const
+{
+   EpochGuard guard;
+   while (true)
+   {
+      Result result = attemptGet(t, holder, 1, 0);
+      if (result != RETRY)
+         return result == YES;
+   }
+}
+
+/*******************************************
+ * ConcurrentBST :: insert
+ *******************************************/
+template <class T>
+bool ConcurrentBST <T> :: insert(const T & t)
+{
+   EpochGuard guard;
+   while (true)
+   {
+      Result result = attemptInsert(t, holder, 1, 0);
+      if (result != RETRY)
+      {
+         if (result == YES)
+            count.fetch_add(1, memory_order_relaxed);
+         return result == YES;
+      }
+   }
+}
+
+/*******************************************
+ * ConcurrentBST :: erase
+ *******************************************/
+template <class T>
+bool ConcurrentBST <T> :: erase(const T & t)
+{
+   EpochGuard guard;
+   while (true)
+   {
+      Result result = attemptErase(t, holder, 1, 0);
+      if (result != RETRY)
+      {
+         if (result == YES)
+            count.fetch_sub(1, memory_order_relaxed);
+         return result == YES;
+      }
+   }
+}
+
+/*******************************************
+ * ConcurrentBST :: waitUntilNotChanging
+ * The rotation holds node's lock, so if a
+ * short spin isn't enough, wait on that
+ *******************************************/
+template <class T>
+void ConcurrentBST <T> :: waitUntilNotChanging(Node * node)
+{
+   unsigned long v = node->version.load();
+   if (!(v & Node::SHRINKING))
+      return;
+
+   for (int i = 0; i < 100; i++)
+      if (node->version.load() != v)
+         return;
+
+   lock_guard<mutex> wait(node->lock);
+}
+
+/*******************************************
+ * ConcurrentBST :: attemptGet
+ * node's version is checked after its link is
+ * read: if it still matches nodeV, child was
+ * really node's child and t belongs under it.
+ * A RETRY from below sends us around this
+ * loop again, not back to the root.
+ *******************************************/
+template <class T>
+typename ConcurrentBST <T> :: Result
+ConcurrentBST <T> :: attemptGet(const T & t, Node * node, int dir,
+                                unsigned long nodeV) const
+{
+   while (true)
+   {
+      Node * child = node->child(dir);
+      if (node->version.load() != nodeV)
+         return RETRY;
+      if (child == NULL)
+         return NO;
+
+      int nextDir = compare(t, child->data);
+      if (nextDir == 0)
+         return child->present.load() ? YES : NO;
+
+      unsigned long childV = child->version.load();
+      if (childV & Node::SHRINKING)
+         waitUntilNotChanging(child);
+      else if (!(childV & Node::UNLINKED) && child == node->child(dir))
+      {
+         if (node->version.load() != nodeV)
+            return RETRY;
+         Result result = attemptGet(t, child, nextDir, childV);
+         if (result != RETRY)
+            return result;
+      }
+   }
+}
+
+/*******************************************
+ * ConcurrentBST :: attemptInsert
+ * The same walk.  At the bottom either a new
+ * leaf goes in, or t was a routing node and
+ * becomes present again.
+ *******************************************/
+template <class T>
+typename ConcurrentBST <T> :: Result
+ConcurrentBST <T> :: attemptInsert(const T & t, Node * node, int dir,
+                                   unsigned long nodeV)
+{
+   Result result = RETRY;
+   do
+   {
+      Node * child = node->child(dir);
+      if (node->version.load() != nodeV)
+         return RETRY;
+
+      if (child == NULL)
+         result = attemptAttach(t, node, dir, nodeV);
+      else
+      {
+         int nextDir = compare(t, child->data);
+         if (nextDir == 0)
+            result = attemptRevive(child);
+         else
+         {
+            unsigned long childV = child->version.load();
+            if (childV & Node::SHRINKING)
+               waitUntilNotChanging(child);
+            else if (!(childV & Node::UNLINKED) && child == node->child(dir))
+            {
+               if (node->version.load() != nodeV)
+                  return RETRY;
+               result = attemptInsert(t, child, nextDir, childV);
+            }
+         }
+      }
+   }
+   while (result == RETRY);
+   return result;
+}
+
+/*******************************************
+ * ConcurrentBST :: attemptErase
+ *******************************************/
+template <class T>
+typename ConcurrentBST <T> :: Result
+ConcurrentBST <T> :: attemptErase(const T & t, Node * node, int dir,
+                                  unsigned long nodeV)
+{
+   Result result = RETRY;
+   do
+   {
+      Node * child = node->child(dir);
+      if (node->version.load() != nodeV)
+         return RETRY;
+
+      if (child == NULL)
+         return NO;
+
+      int nextDir = compare(t, child->data);
+      if (nextDir == 0)
+         result = attemptRemove(node, child);
+      else
+      {
+         unsigned long childV = child->version.load();
+         if (childV & Node::SHRINKING)
+            waitUntilNotChanging(child);
+         else if (!(childV & Node::UNLINKED) && child == node->child(dir))
+         {
+            if (node->version.load() != nodeV)
+               return RETRY;
+            result = attemptErase(t, child, nextDir, childV);
+         }
+      }
+   }
+   while (result == RETRY);
+   return result;
+}
+
+/*******************************************
+ * ConcurrentBST :: attemptAttach
+ * The new node is made before the lock is
+ * taken and thrown away if we lose the race.
+ *******************************************/
+template <class T>
+typename ConcurrentBST <T> :: Result
+ConcurrentBST <T> :: attemptAttach(const T & t, Node * node, int dir,
+                                   unsigned long nodeV)
+{
+   Node * fresh = new Node(t, node);
+   {
+      lock_guard<mutex> locked(node->lock);
+      if (node->version.load() != nodeV || node->child(dir) != NULL)
+      {
+         delete fresh; // never seen by anyone
+         return RETRY;
+      }
+      node->setChild(dir, fresh);
+   }
+
+   fixHeightAndRebalance(node);
+   return YES;
+}
+
+/*******************************************
+ * ConcurrentBST :: attemptRevive
+ *******************************************/
+template <class T>
+typename ConcurrentBST <T> :: Result
+ConcurrentBST <T> :: attemptRevive(Node * node)
+{
+   lock_guard<mutex> locked(node->lock);
+   if (node->version.load() & Node::UNLINKED)
+      return RETRY;
+   if (node->present.load())
+      return NO;
+   node->present.store(true);
+   return YES;
+}
+
+/*******************************************
+ * ConcurrentBST :: attemptRemove
+ * With two children node just becomes a
+ * routing node.  With one or none it comes
+ * out, which takes its parent's lock too.
+ *******************************************/
+template <class T>
+typename ConcurrentBST <T> :: Result
+ConcurrentBST <T> :: attemptRemove(Node * parent, Node * node)
+{
+   if (!node->present.load())
+      return NO;
+
+   if (node->left.load() && node->right.load())
+   {
+      lock_guard<mutex> locked(node->lock);
+      if ((node->version.load() & Node::UNLINKED) ||
+          !node->left.load() || !node->right.load())
+         return RETRY;
+      if (!node->present.load())
+         return NO;
+      node->present.store(false);
+      return YES;
+   }
+
+   {
+      lock_guard<mutex> lockedParent(parent->lock);
+      if ((parent->version.load() & Node::UNLINKED) || node->parent.load() != parent)
+         return RETRY;
+
+      lock_guard<mutex> locked(node->lock);
+      if (!node->present.load())
+         return NO;
+      if (!attemptUnlink_nl(parent, node))
+         return RETRY;
+   }
+
+   fixHeightAndRebalance(parent);
+   return YES;
+}
+
+/*******************************************
+ * ConcurrentBST :: attemptUnlink_nl
+ * Only a node with at most one child can
+ * come out; that child takes its place.
+ *******************************************/
+template <class T>
+bool ConcurrentBST <T> :: attemptUnlink_nl(Node * parent, Node * node)
+{
+   Node * pL = parent->left.load();
+   Node * pR = parent->right.load();
+   if (pL != node && pR != node)
+      return false;
+
+   Node * nL = node->left.load();
+   Node * nR = node->right.load();
+   if (nL && nR)
+      return false;
+
+   Node * splice = nL ? nL : nR;
+   if (pL == node)
+      parent->left.store(splice);
+   else
+      parent->right.store(splice);
+   if (splice)
+      splice->parent.store(parent);
+
+   node->version.store(Node::UNLINKED);
+   node->present.store(false);
+   Epoch::retire(node);
+   return true;
+}
+
+/*******************************************
+ * ConcurrentBST :: nodeCondition
+ * The height node should have, or that it
+ * needs a rotation or to come out
+ *******************************************/
+template <class T>
+int ConcurrentBST <T> :: nodeCondition(Node * node)
+{
+   Node * nL = node->left.load();
+   Node * nR = node->right.load();
+   if ((!nL || !nR) && !node->present.load())
+      return UNLINK_REQUIRED;
+
+   int hN = node->height.load();
+   int hL0 = heightOf(nL);
+   int hR0 = heightOf(nR);
+   int hNRepl = 1 + max(hL0, hR0);
+   int bal = hL0 - hR0;
+   if (bal < -1 || bal > 1)
+      return REBALANCE_REQUIRED;
+   return hN != hNRepl ? hNRepl : NOTHING_REQUIRED;
+}
+
+/*******************************************
+ * ConcurrentBST :: fixHeightAndRebalance
+ * Walk up from node until nothing needs
+ * fixing.  A new height needs only node's
+ * lock; a rotation or unlink needs its
+ * parent's as well.
+ *    A rotation that hands back a node below
+ * it to work on next may have changed the
+ * height under parent too, and the walk up
+ * from that node can stop before getting
+ * there.  So parent is kept to look at again
+ * once the walk is done.
+ *******************************************/
+template <class T>
+void ConcurrentBST <T> :: fixHeightAndRebalance(Node * node)
+{
+   vector<Node *> later;
+   while (true)
+   {
+      int condition = NOTHING_REQUIRED;
+      if (node && node->parent.load() &&   // the holder has no parent
+          !(node->version.load() & Node::UNLINKED))
+         condition = nodeCondition(node);
+
+      if (condition == NOTHING_REQUIRED)
+      {
+         if (later.empty())
+            return;
+         node = later.back();
+         later.pop_back();
+      }
+      else if (condition != UNLINK_REQUIRED && condition != REBALANCE_REQUIRED)
+      {
+         lock_guard<mutex> locked(node->lock);
+         node = fixHeight_nl(node);
+      }
+      else
+      {
+         Node * parent = node->parent.load();
+         lock_guard<mutex> lockedParent(parent->lock);
+         if (!(parent->version.load() & Node::UNLINKED) && node->parent.load() == parent)
+         {
+            lock_guard<mutex> locked(node->lock);
+            node = rebalance_nl(parent, node);
+            if (node)
+               later.push_back(parent);
+         }
+      }
+   }
+}
+
+/*******************************************
+ * ConcurrentBST :: fixHeight_nl
+ *******************************************/
+template <class T>
+ConcurrentBSTNode <T> * ConcurrentBST <T> :: fixHeight_nl(Node * node)
+{
+   int condition = nodeCondition(node);
+   switch (condition)
+   {
+      case REBALANCE_REQUIRED:
+      case UNLINK_REQUIRED:
+         return node;
+      case NOTHING_REQUIRED:
+         return NULL;
+      default:
+         node->height.store(condition);
+         return node->parent.load();
+   }
+}
+
+/*******************************************
+ * ConcurrentBST :: rebalance_nl
+ *******************************************/
+template <class T>
+ConcurrentBSTNode <T> * ConcurrentBST <T> :: rebalance_nl(Node * parent, Node * node)
+{
+   Node * nL = node->left.load();
+   Node * nR = node->right.load();
+   if ((!nL || !nR) && !node->present.load())
+      return attemptUnlink_nl(parent, node) ? fixHeight_nl(parent) : node;
+
+   int hN = node->height.load();
+   int hL0 = heightOf(nL);
+   int hR0 = heightOf(nR);
+   int hNRepl = 1 + max(hL0, hR0);
+   int bal = hL0 - hR0;
+
+   if (bal > 1)
+      return rebalanceToRight_nl(parent, node, nL, hR0);
+   if (bal < -1)
+      return rebalanceToLeft_nl(parent, node, nR, hL0);
+   if (hNRepl != hN)
+   {
+      node->height.store(hNRepl);
+      return fixHeight_nl(parent);
+   }
+   return NULL;
+}
+
+/*******************************************
+ * ConcurrentBST :: rebalanceToRight_nl
+ * node is left heavy.  One rotation if nL's
+ * left is the tall side, two if it is nL's
+ * right.  If two would leave nL out of
+ * balance, or a routing node with a missing
+ * child, rotate nL alone and let the caller
+ * come back for node.
+ *******************************************/
+template <class T>
+ConcurrentBSTNode <T> * ConcurrentBST <T> :: rebalanceToRight_nl(Node * parent, Node * node,
+                                                                 Node * nL, int hR0)
+{
+   lock_guard<mutex> lockedL(nL->lock);
+   int hL = nL->height.load();
+   if (hL - hR0 <= 1)
+      return node; // changed under us, look again
+
+   Node * nLR = nL->right.load();
+   int hLL0 = heightOf(nL->left.load());
+   int hLR0 = heightOf(nLR);
+   if (hLL0 >= hLR0)
+      return rotateRight_nl(parent, node, nL, hR0, hLL0, nLR, hLR0);
+
+   {
+      lock_guard<mutex> lockedLR(nLR->lock);
+      int hLR = nLR->height.load();
+      if (hLL0 >= hLR)
+         return rotateRight_nl(parent, node, nL, hR0, hLL0, nLR, hLR);
+
+      Node * nLRL = nLR->left.load();
+      int hLRL = heightOf(nLRL);
+      int b = hLL0 - hLRL;
+      if (b >= -1 && b <= 1 && !((hLL0 == 0 || hLRL == 0) && !nL->present.load()))
+         return rotateRightOverLeft_nl(parent, node, nL, hR0, hLL0, nLR, hLRL);
+
+      // just turn nL left now; node gets a single rotation next time
+      return rotateLeft_nl(node, nL, hLL0, nLR, nLRL, hLRL,
+                           heightOf(nLR->right.load()));
+   }
+}
+
+/*******************************************
+ * ConcurrentBST :: rebalanceToLeft_nl
+ * the mirror image
+ *******************************************/
+template <class T>
+ConcurrentBSTNode <T> * ConcurrentBST <T> :: rebalanceToLeft_nl(Node * parent, Node * node,
+                                                                Node * nR, int hL0)
+{
+   lock_guard<mutex> lockedR(nR->lock);
+   int hR = nR->height.load();
+   if (hL0 - hR >= -1)
+      return node; // changed under us, look again
+
+   Node * nRL = nR->left.load();
+   int hRL0 = heightOf(nRL);
+   int hRR0 = heightOf(nR->right.load());
+   if (hRR0 >= hRL0)
+      return rotateLeft_nl(parent, node, hL0, nR, nRL, hRL0, hRR0);
+
+   {
+      lock_guard<mutex> lockedRL(nRL->lock);
+      int hRL = nRL->height.load();
+      if (hRR0 >= hRL)
+         return rotateLeft_nl(parent, node, hL0, nR, nRL, hRL, hRR0);
+
+      Node * nRLR = nRL->right.load();
+      int hRLR = heightOf(nRLR);
+      int b = hRR0 - hRLR;
+      if (b >= -1 && b <= 1 && !((hRR0 == 0 || hRLR == 0) && !nR->present.load()))
+         return rotateLeftOverRight_nl(parent, node, hL0, nR, nRL, hRR0, hRLR);
+
+      // just turn nR right now; node gets a single rotation next time
+      return rotateRight_nl(node, nR, nRL, hRR0, heightOf(nRL->left.load()),
+                            nRLR, hRLR);
+   }
+}
+
+/*******************************************
+ * ConcurrentBST :: rotateRight_nl
+ * nL takes node's place and node becomes its
+ * right child.  node loses nL's left side, so
+ * it is the one that shrinks.  The result is
+ * whichever node still needs work.
+ *******************************************/
+template <class T>
+ConcurrentBSTNode <T> * ConcurrentBST <T> :: rotateRight_nl(Node * parent, Node * node,
+                                                            Node * nL, int hR, int hLL,
+                                                            Node * nLR, int hLR)
+{
+   unsigned long nodeV = node->version.load();
+   Node * pL = parent->left.load();
+
+   node->version.store(Node::beginChange(nodeV));
+
+   node->left.store(nLR);
+   if (nLR)
+      nLR->parent.store(node);
+   nL->right.store(node);
+   node->parent.store(nL);
+   if (pL == node)
+      parent->left.store(nL);
+   else
+      parent->right.store(nL);
+   nL->parent.store(parent);
+
+   int hNRepl = 1 + max(hLR, hR);
+   node->height.store(hNRepl);
+   nL->height.store(1 + max(hLL, hNRepl));
+
+   node->version.store(Node::endChange(nodeV));
+
+   int balN = hLR - hR;
+   if (balN < -1 || balN > 1)
+      return node;
+   if ((!nLR || hR == 0) && !node->present.load())
+      return node;
+   int balL = hLL - hNRepl;
+   if (balL < -1 || balL > 1)
+      return nL;
+   if (hLL == 0 && !nL->present.load())
+      return nL;
+   return fixHeight_nl(parent);
+}
+
+/*******************************************
+ * ConcurrentBST :: rotateLeft_nl
+ * the mirror image
+ *******************************************/
+template <class T>
+ConcurrentBSTNode <T> * ConcurrentBST <T> :: rotateLeft_nl(Node * parent, Node * node,
+                                                           int hL, Node * nR, Node * nRL,
+                                                           int hRL, int hRR)
+{
+   unsigned long nodeV = node->version.load();
+   Node * pL = parent->left.load();
+
+   node->version.store(Node::beginChange(nodeV));
+
+   node->right.store(nRL);
+   if (nRL)
+      nRL->parent.store(node);
+   nR->left.store(node);
+   node->parent.store(nR);
+   if (pL == node)
+      parent->left.store(nR);
+   else
+      parent->right.store(nR);
+   nR->parent.store(parent);
+
+   int hNRepl = 1 + max(hL, hRL);
+   node->height.store(hNRepl);
+   nR->height.store(1 + max(hNRepl, hRR));
+
+   node->version.store(Node::endChange(nodeV));
+
+   int balN = hRL - hL;
+   if (balN < -1 || balN > 1)
+      return node;
+   if ((!nRL || hL == 0) && !node->present.load())
+      return node;
+   int balR = hRR - hNRepl;
+   if (balR < -1 || balR > 1)
+      return nR;
+   if (hRR == 0 && !nR->present.load())
+      return nR;
+   return fixHeight_nl(parent);
+}
+
+/*******************************************
+ * ConcurrentBST :: rotateRightOverLeft_nl
+ * nLR comes up two levels, with nL on its
+ * left and node on its right.  Both of those
+ * shrink.
+ *******************************************/
+template <class T>
+ConcurrentBSTNode <T> * ConcurrentBST <T> :: rotateRightOverLeft_nl(Node * parent, Node * node,
+                                                                    Node * nL, int hR, int hLL,
+                                                                    Node * nLR, int hLRL)
+{
+   unsigned long nodeV = node->version.load();
+   unsigned long leftV = nL->version.load();
+   Node * pL = parent->left.load();
+   Node * nLRL = nLR->left.load();
+   Node * nLRR = nLR->right.load();
+   int hLRR = heightOf(nLRR);
+
+   node->version.store(Node::beginChange(nodeV));
+   nL->version.store(Node::beginChange(leftV));
+
+   node->left.store(nLRR);
+   if (nLRR)
+      nLRR->parent.store(node);
+   nL->right.store(nLRL);
+   if (nLRL)
+      nLRL->parent.store(nL);
+   nLR->left.store(nL);
+   nL->parent.store(nLR);
+   nLR->right.store(node);
+   node->parent.store(nLR);
+   if (pL == node)
+      parent->left.store(nLR);
+   else
+      parent->right.store(nLR);
+   nLR->parent.store(parent);
+
+   int hNRepl = 1 + max(hLRR, hR);
+   node->height.store(hNRepl);
+   int hLRepl = 1 + max(hLL, hLRL);
+   nL->height.store(hLRepl);
+   nLR->height.store(1 + max(hLRepl, hNRepl));
+
+   node->version.store(Node::endChange(nodeV));
+   nL->version.store(Node::endChange(leftV));
+
+   int balN = hLRR - hR;
+   if (balN < -1 || balN > 1)
+      return node;
+   if ((!nLRR || hR == 0) && !node->present.load())
+      return node;
+   int balLR = hLRepl - hNRepl;
+   if (balLR < -1 || balLR > 1)
+      return nLR;
+   return fixHeight_nl(parent);
+}
+
+/*******************************************
+ * ConcurrentBST :: rotateLeftOverRight_nl
+ * the mirror image
+ *******************************************/
+template <class T>
+ConcurrentBSTNode <T> * ConcurrentBST <T> :: rotateLeftOverRight_nl(Node * parent, Node * node,
+                                                                    int hL, Node * nR, Node * nRL,
+                                                                    int hRR, int hRLR)
+{
+   unsigned long nodeV = node->version.load();
+   unsigned long rightV = nR->version.load();
+   Node * pL = parent->left.load();
+   Node * nRLL = nRL->left.load();
+   Node * nRLR = nRL->right.load();
+   int hRLL = heightOf(nRLL);
+
+   node->version.store(Node::beginChange(nodeV));
+   nR->version.store(Node::beginChange(rightV));
+
+   node->right.store(nRLL);
+   if (nRLL)
+      nRLL->parent.store(node);
+   nR->left.store(nRLR);
+   if (nRLR)
+      nRLR->parent.store(nR);
+   nRL->right.store(nR);
+   nR->parent.store(nRL);
+   nRL->left.store(node);
+   node->parent.store(nRL);
+   if (pL == node)
+      parent->left.store(nRL);
+   else
+      parent->right.store(nRL);
+   nRL->parent.store(parent);
+
+   int hNRepl = 1 + max(hL, hRLL);
+   node->height.store(hNRepl);
+   int hRRepl = 1 + max(hRLR, hRR);
+   nR->height.store(hRRepl);
+   nRL->height.store(1 + max(hNRepl, hRRepl));
+
+   node->version.store(Node::endChange(nodeV));
+   nR->version.store(Node::endChange(rightV));
+
+   int balN = hRLL - hL;
+   if (balN < -1 || balN > 1)
+      return node;
+   if ((!nRLL || hL == 0) && !node->present.load())
+      return node;
+   int balRL = hRRepl - hNRepl;
+   if (balRL < -1 || balRL > 1)
+      return nRL;
+   return fixHeight_nl(parent);
+}
+
+#endif // CONCURRENTBST_H
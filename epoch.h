@@ -0,0 +1,221 @@
+/***************************************************************
+ * File: epoch.h
+ * Author: Ryan Walker
+ * Purpose: Contains the Epoch class and EpochGuard class.
+ *    Epoch-based memory reclamation for the lock-free containers.
+ * A thread holds an EpochGuard while it touches shared nodes.  A
+ * node that has been unlinked is handed to Epoch::retire() instead
+ * of delete, and it is only really deleted once every thread that
+ * was inside a guard when it was retired has left that guard.
+ ***************************************************************/
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+/************************************************
+ * Epoch
+ * One global epoch number and one record per
+ * thread.  The epoch can only move forward once
+ * every thread inside a guard has seen the
+ * current one, so anything retired two epochs
+ * ago can't be in anybody's hands.
+ ***********************************************/
+class Epoch
+{
+public:
+   // something waiting to be deleted
+   struct Retired
+   {
+      void * p;
+      void (*destroy)(void *);
+      unsigned long epoch;
+   };
+
+   // what each thread keeps.  Records are never freed, a record
+   // whose thread has exited is picked up by the next new thread.
+   struct Record
+   {
+      atomic<unsigned long> state;   // (epoch << 1) | 1 inside a guard, 0 outside
+      atomic<bool> inUse;            // does a thread own this record?
+      int nesting;                   // how many guards deep
+      vector<Retired> limbo;         // retired but not yet deleted
+      Record * next;                 // next in the registry
+
+      Record() : state(0), inUse(true), nesting(0), next(NULL) {}
+   };
+
+   // enter and leave a critical section (EpochGuard does this for you)
+   static void enter();
+   static void exit();
+
+   // delete p with destroy(p) once nobody can be looking at it
+   static void retire(void * p, void (*destroy)(void *));
+
+   // same, for anything that can be deleted with delete
+   template <class T>
+   static void retire(T * p) { retire(p, &destroyAs<T>); }
+
+   // delete whatever this thread has that is old enough
+   static void collect();
+
+private:
+   template <class T>
+   static void destroyAs(void * p) { delete static_cast<T *>(p); }
+
+   // move the epoch forward if every active thread has seen it
+   static bool tryAdvance();
+
+   // this thread's record, found or made on first use
+   static Record * record();
+
+   static atomic<unsigned long> & global()
+   {
+      static atomic<unsigned long> epoch(2);
+      return epoch;
+   }
+
+   static atomic<Record *> & registry()
+   {
+      static atomic<Record *> head(NULL);
+      return head;
+   }
+
+   // gives the record back when its thread exits
+   struct Owner
+   {
+      Record * rec;
+      Owner() : rec(NULL) {}
+      ~Owner()
+      {
+         if (rec)
+         {
+            collect();
+            rec->inUse.store(false);
+         }
+      }
+   };
+};
+
+/************************************************
+ * EpochGuard
+ * Holds the epoch open for as long as it lives.
+ * Guards nest, so a function that takes one can
+ * call another that does too.
+ ***********************************************/
+class EpochGuard
+{
+public:
+   EpochGuard()                      { Epoch::enter(); }
+   EpochGuard(const EpochGuard &)    { Epoch::enter(); }
+   ~EpochGuard()                     { Epoch::exit();  }
+   EpochGuard & operator = (const EpochGuard &) { return *this; }
+};
+
+/*******************************************
+ * Epoch :: record
+ * Reuse a record some exited thread left
+ * behind, or push a new one on the registry.
+ *******************************************/
+inline Epoch::Record * Epoch :: record()
+{
+   static thread_local Owner owner;
+   if (owner.rec)
+      return owner.rec;
+
+   for (Record * r = registry().load(); r; r = r->next)
+   {
+      bool expected = false;
+      if (!r->inUse.load() && r->inUse.compare_exchange_strong(expected, true))
+         return owner.rec = r;
+   }
+
+   Record * r = new Record;
+   Record * head = registry().load();
+   do
+      r->next = head;
+   while (!registry().compare_exchange_weak(head, r));
+
+   return owner.rec = r;
+}
+
+/*******************************************
+ * Epoch :: enter
+ *******************************************/
+inline void Epoch :: enter()
+{
+   Record * r = record();
+   if (r->nesting++ == 0)
+   {
+      r->state.store((global().load() << 1) | 1);
+      atomic_thread_fence(memory_order_seq_cst);
+   }
+}
+
+/*******************************************
+ * Epoch :: exit
+ *******************************************/
+inline void Epoch :: exit()
+{
+   Record * r = record();
+   assert(r->nesting > 0);
+   if (--r->nesting == 0)
+      r->state.store(0, memory_order_release);
+}
+
+/*******************************************
+ * Epoch :: tryAdvance
+ *******************************************/
+inline bool Epoch :: tryAdvance()
+{
+   unsigned long e = global().load();
+   for (Record * r = registry().load(); r; r = r->next)
+   {
+      unsigned long s = r->state.load();
+      if ((s & 1) && (s >> 1) != e)
+         return false; // someone is still back in an older epoch
+   }
+   return global().compare_exchange_strong(e, e + 1);
+}
+
+/*******************************************
+ * Epoch :: collect
+ *******************************************/
+inline void Epoch :: collect()
+{
+   Record * r = record();
+   tryAdvance();
+   unsigned long safe = global().load() - 2;
+
+   size_t keep = 0;
+   for (size_t i = 0; i < r->limbo.size(); i++)
+   {
+      if (r->limbo[i].epoch <= safe)
+         r->limbo[i].destroy(r->limbo[i].p);
+      else
+         r->limbo[keep++] = r->limbo[i];
+   }
+   r->limbo.resize(keep);
+}
+
+/*******************************************
+ * Epoch :: retire
+ * Every 64 retired nodes we try to move the
+ * epoch along and delete what we can.
+ *******************************************/
+inline void Epoch :: retire(void * p, void (*destroy)(void *))
+{
+   Record * r = record();
+   Retired item = { p, destroy, global().load() };
+   r->limbo.push_back(item);
+
+   if (r->limbo.size() % 64 == 0)
+      collect();
+}
+
+#endif // EPOCH_H
@@ -0,0 +1,85 @@
+/***************************************************************
+ * File: hashmap.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the HashMap class.  An
+ *    unordered map from K to V on the open-addressing HashTable
+ * (see hashtable.h).  Each slot is a pair, first the key and
+ * second the value, kept together so a hit reads one cache line.
+ ***************************************************************/
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include "hashtable.h"
+#include <functional>
+#include <utility>
+
+using namespace std;
+
+/************************************************
+ * HashMapKey
+ * A HashMap slot's key is its first.
+ ***********************************************/
+template <class K, class V>
+struct HashMapKey
+{
+   static const K & key(const pair<K, V> & slot) { return slot.first; }
+};
+
+/************************************************
+ * HashMap
+ * The iterators give a pair<K, V> &.  Change the
+ * second all you like; changing the first loses
+ * the entry.
+ ***********************************************/
+template <class K, class V, class Hash = hash<K>, class Equal = equal_to<K> >
+class HashMap : public HashTable<pair<K, V>, K, HashMapKey<K, V>, pair<K, V> &, Hash, Equal>
+{
+public:
+   typedef HashTable<pair<K, V>, K, HashMapKey<K, V>, pair<K, V> &, Hash, Equal> Table;
+   typedef typename Table::iterator iterator;
+
+   // construct : optionally with room for numReserve entries
+   HashMap(int numReserve = 0, const Hash & hasher = Hash(),
+           const Equal & equal = Equal()) throw (const char *)
+      : Table(numReserve, hasher, equal) {}
+
+   // add key -> value, false (and value not stored) if key was there
+   bool insert(const K & key, const V & value) throw (const char *)
+   {
+      return this->lookupOrInsert(key, [&](void * p)
+      {
+         new (p) pair<K, V>(key, value);
+      }).second;
+   }
+
+   // the value for key, default constructed if key is new
+   V & operator [] (const K & key) throw (const char *)
+   {
+      int i = this->lookupOrInsert(key, [&](void * p)
+      {
+         new (p) pair<K, V>(key, V());
+      }).first;
+      return this->slots[i].second;
+   }
+
+   // the value for key, which must be there
+   template <class Q>
+   V & at(const Q & key) throw (const char *)
+   {
+      int i = this->lookup(key);
+      if (i < 0)
+         throw "ERROR: Key not in HashMap";
+      return this->slots[i].second;
+   }
+
+   template <class Q>
+   const V & at(const Q & key) const throw (const char *)
+   {
+      int i = this->lookup(key);
+      if (i < 0)
+         throw "ERROR: Key not in HashMap";
+      return this->slots[i].second;
+   }
+};
+
+#endif // HASHMAP_H
@@ -0,0 +1,56 @@
+/***************************************************************
+ * File: hashset.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the HashSet class.  An
+ *    unordered set on the open-addressing HashTable (see
+ * hashtable.h): O(1) insert, find and erase, no ordering.  Use Set
+ * when you need the items in order.
+ ***************************************************************/
+#ifndef HASHSET_H
+#define HASHSET_H
+
+#include "hashtable.h"
+#include <functional>
+
+using namespace std;
+
+/************************************************
+ * HashSetKey
+ * A HashSet slot is its own key.
+ ***********************************************/
+template <class T>
+struct HashSetKey
+{
+   static const T & key(const T & t) { return t; }
+};
+
+/************************************************
+ * HashSet
+ * Items are read-only through the iterators, as
+ * changing one would lose it in the table.
+ ***********************************************/
+template <class T, class Hash = hash<T>, class Equal = equal_to<T> >
+class HashSet : public HashTable<T, T, HashSetKey<T>, const T &, Hash, Equal>
+{
+public:
+   typedef HashTable<T, T, HashSetKey<T>, const T &, Hash, Equal> Table;
+   typedef typename Table::iterator iterator;
+
+   // construct : optionally with room for numReserve items
+   HashSet(int numReserve = 0, const Hash & hasher = Hash(),
+           const Equal & equal = Equal()) throw (const char *)
+      : Table(numReserve, hasher, equal) {}
+
+   // add t, false if it was already there
+   bool insert(const T & t) throw (const char *)
+   {
+      return this->lookupOrInsert(t, [&](void * p) { new (p) T(t); }).second;
+   }
+
+   bool insert(T && t) throw (const char *)
+   {
+      return this->lookupOrInsert(t, [&](void * p) { new (p) T(std::move(t)); }).second;
+   }
+};
+
+#endif // HASHSET_H
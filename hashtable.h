@@ -0,0 +1,585 @@
+/***************************************************************
+ * File: hashtable.h
+ * Author: Ryan Walker
+ * Purpose: Contains the HashTable class that HashSet and HashMap
+ *    are built on.  It is an open-addressing table in the style of
+ * Abseil's SwissTable.  Next to the slots is one control byte per
+ * slot: empty, deleted, or the low 7 bits of the slot's hash.  The
+ * slots are probed sixteen at a time.  One SSE2 compare checks a
+ * whole group of control bytes against the hash, so almost every
+ * lookup touches one group of control bytes and one slot.
+ *
+ *    Erasing leaves a tombstone (deleted) unless the slot's group
+ * still has an empty slot, in which case nothing can have probed
+ * past it and the slot goes straight back to empty.
+ ***************************************************************/
+#ifndef HASHTABLE_H
+#define HASHTABLE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// slots per group, one SSE2 register of control bytes
+#define HASH_GROUP 16
+
+// control bytes.  Full slots hold 0..127, the low 7 bits of the hash.
+#define HASH_EMPTY   ((signed char)-128)
+#define HASH_DELETED ((signed char)-2)
+
+/************************************************
+ * HashGroup
+ * The control bytes of one group, with bit masks
+ * (bit i for slot i of the group) of the slots
+ * that match.
+ ***********************************************/
+struct HashGroup
+{
+#ifdef __SSE2__
+   __m128i ctrl;
+
+   HashGroup(const signed char * p) : ctrl(_mm_loadu_si128((const __m128i *)p)) {}
+
+   // slots whose hash bits are h2
+   unsigned match(signed char h2) const
+   {
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+   }
+
+   // empty or deleted slots: the only control bytes with the high bit set
+   unsigned matchFree() const { return _mm_movemask_epi8(ctrl); }
+#else
+   const signed char * ctrl;
+
+   HashGroup(const signed char * p) : ctrl(p) {}
+
+   unsigned match(signed char h2) const
+   {
+      unsigned bits = 0;
+      for (int i = 0; i < HASH_GROUP; i++)
+         if (ctrl[i] == h2)
+            bits |= 1u << i;
+      return bits;
+   }
+
+   unsigned matchFree() const
+   {
+      unsigned bits = 0;
+      for (int i = 0; i < HASH_GROUP; i++)
+         if (ctrl[i] < 0)
+            bits |= 1u << i;
+      return bits;
+   }
+#endif
+
+   // empty slots
+   unsigned matchEmpty() const { return match(HASH_EMPTY); }
+
+   // the lowest set bit of a mask
+   static int first(unsigned bits) { return __builtin_ctz(bits); }
+};
+
+/************************************************
+ * StringHash, StringEqual
+ * Hash and compare a string and a C string the
+ * same way, so a HashSet<string, StringHash,
+ * StringEqual> can be searched with a const char *
+ * without building a string first.
+ ***********************************************/
+struct StringHash
+{
+   typedef void is_transparent;
+
+   // FNV-1a
+   size_t operator () (const char * s, size_t len) const
+   {
+      size_t h = (size_t)14695981039346656037ULL;
+      for (size_t i = 0; i < len; i++)
+         h = (h ^ (unsigned char)s[i]) * (size_t)1099511628211ULL;
+      return h;
+   }
+   size_t operator () (const string & s) const { return (*this)(s.data(), s.size()); }
+   size_t operator () (const char * s) const   { return (*this)(s, strlen(s));      }
+};
+
+struct StringEqual
+{
+   typedef void is_transparent;
+
+   bool operator () (const string & lhs, const string & rhs) const { return lhs == rhs; }
+   bool operator () (const string & lhs, const char * rhs) const   { return lhs == rhs; }
+   bool operator () (const char * lhs, const string & rhs) const   { return rhs == lhs; }
+};
+
+/************************************************
+ * HashTableIterator
+ * Walks the full slots in slot order.  Ref is
+ * what the container lets you see of a slot.
+ ***********************************************/
+template <class Slot, class Ref>
+class HashTableIterator
+{
+public:
+   HashTableIterator() : ctrl(NULL), slots(NULL), i(0), cap(0) {}
+   HashTableIterator(const signed char * ctrl, Slot * slots, int i, int cap)
+      : ctrl(ctrl), slots(slots), i(i), cap(cap)   { skip(); }
+
+   bool operator != (const HashTableIterator & rhs) const { return i != rhs.i; }
+   bool operator == (const HashTableIterator & rhs) const { return i == rhs.i; }
+
+   // dereference operator
+   Ref operator * () const                                 { return slots[i]; }
+   typename remove_reference<Ref>::type * operator -> () const { return &slots[i]; }
+
+   // prefix increment
+   HashTableIterator & operator ++ ()
+   {
+      i++;
+      skip();
+      return *this;
+   }
+
+   // postfix increment
+   HashTableIterator operator ++ (int)
+   {
+      HashTableIterator tmp(*this);
+      ++(*this);
+      return tmp;
+   }
+
+   // which slot, for HashTable::erase
+   int index() const { return i; }
+
+private:
+   // move forward to a full slot or the end
+   void skip()
+   {
+      while (i < cap && ctrl[i] < 0)
+         i++;
+   }
+
+   const signed char * ctrl;
+   Slot * slots;
+   int i;
+   int cap;
+};
+
+/************************************************
+ * HashTable
+ * Slot is what is stored, KeyOf::key(slot) is its
+ * key.  Lookups are templates so any type the Hash
+ * and Equal accept can be used to search.
+ ***********************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+class HashTable
+{
+public:
+   typedef HashTableIterator<Slot, Ref> iterator;
+
+   // construct : room for numReserve items before the first rehash
+   HashTable(int numReserve, const Hash & hasher, const Equal & equal) throw (const char *);
+
+   // copy constructor : same capacity, same layout
+   HashTable(const HashTable & rhs) throw (const char *);
+
+   // destructor
+   ~HashTable()                   { destroy(); }
+
+   // assignment operator
+   HashTable & operator = (const HashTable & rhs) throw (const char *);
+
+   // how many items are in the table?
+   int size() const               { return numItems;      }
+   bool empty() const             { return numItems == 0; }
+
+   // how many slots are there?
+   int capacity() const           { return cap;           }
+
+   // drop every item, keep the slots
+   void clear();
+
+   // make room for n items without rehashing
+   void reserve(int n) throw (const char *);
+
+   // find the item with key equal to key, or end()
+   template <class Q>
+   iterator find(const Q & key) const
+   {
+      int i = lookup(key);
+      return i < 0 ? end() : iterator(ctrl, slots, i, cap);
+   }
+
+   // is key in the table?
+   template <class Q>
+   bool contains(const Q & key) const  { return lookup(key) >= 0;     }
+
+   template <class Q>
+   int count(const Q & key) const      { return lookup(key) >= 0 ? 1 : 0; }
+
+   // remove key if it is there
+   template <class Q>
+   bool erase(const Q & key)
+   {
+      int i = lookup(key);
+      if (i < 0)
+         return false;
+      eraseAt(i);
+      return true;
+   }
+
+   // remove the item it points to
+   void erase(const iterator & it)     { eraseAt(it.index()); }
+
+   iterator begin() const              { return iterator(ctrl, slots, 0, cap);   }
+   iterator end() const                { return iterator(ctrl, slots, cap, cap); }
+
+protected:
+   // index of the slot holding key, or -1
+   template <class Q>
+   int lookup(const Q & key) const;
+
+   // index of the slot holding key, or a new slot made for it
+   // with make(void *), and whether it was new
+   template <class Q, class Make>
+   pair<int, bool> lookupOrInsert(const Q & key, Make make) throw (const char *);
+
+   Slot * slots;         // cap slots, the full ones constructed
+   signed char * ctrl;   // cap control bytes
+
+private:
+   // scramble the user's hash so both the group and the 7 bits
+   // stored in the control byte come out well mixed
+   static size_t mix(size_t h)
+   {
+      unsigned long long m = (unsigned long long)h * 0x9E3779B97F4A7C15ULL;
+      return (size_t)(m ^ (m >> 32));
+   }
+
+   // at most 7/8 of the slots may be used (tombstones count)
+   static int maxLoad(int cap)  { return cap - cap / 8; }
+
+   // first free slot on h's probe sequence
+   int findFree(size_t h) const;
+
+   // take slot i out
+   void eraseAt(int i);
+
+   // move everything into cap slots
+   void rehash(int newCap) throw (const char *);
+
+   // free everything
+   void destroy();
+
+   int cap;              // zero, or a power of two at least HASH_GROUP
+   int numItems;
+   int growthLeft;       // empty slots we may still fill before a rehash
+   Hash hasher;
+   Equal equal;
+};
+
+/*******************************************
+ * HashTable :: CONSTRUCTOR
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> :: HashTable(int numReserve,
+                                                            const Hash & hasher,
+                                                            const Equal & equal)
+   throw (const char *)
+   : slots(NULL), ctrl(NULL), cap(0), numItems(0), growthLeft(0),
+     hasher(hasher), equal(equal)
+{
+   reserve(numReserve);
+}
+
+/*******************************************
+ * HashTable :: COPY CONSTRUCTOR
+ * The control bytes can be copied as they are
+ * since the copy has the same capacity.
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> :: HashTable(const HashTable & rhs)
+   throw (const char *)
+   : slots(NULL), ctrl(NULL), cap(0), numItems(0), growthLeft(0),
+     hasher(rhs.hasher), equal(rhs.equal)
+{
+   if (rhs.cap == 0)
+      return;
+
+   try
+   {
+      ctrl = new signed char[rhs.cap];
+      slots = (Slot *)::operator new(sizeof(Slot) * rhs.cap);
+   }
+   catch (std::bad_alloc)
+   {
+      delete [] ctrl;
+      ctrl = NULL;
+      throw "ERROR: Unable to allocate buffer";
+   }
+
+   memcpy(ctrl, rhs.ctrl, rhs.cap);
+   for (int i = 0; i < rhs.cap; i++)
+      if (ctrl[i] >= 0)
+         new ((void *)(slots + i)) Slot(rhs.slots[i]);
+
+   cap = rhs.cap;
+   numItems = rhs.numItems;
+   growthLeft = rhs.growthLeft;
+}
+
+/*******************************************
+ * HashTable :: ASSIGNMENT OPERATOR
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> &
+HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> :: operator = (const HashTable & rhs)
+   throw (const char *)
+{
+   if (this == &rhs)
+      return *this;
+
+   HashTable copy(rhs);
+   swap(slots, copy.slots);
+   swap(ctrl, copy.ctrl);
+   swap(cap, copy.cap);
+   swap(numItems, copy.numItems);
+   swap(growthLeft, copy.growthLeft);
+   swap(hasher, copy.hasher);
+   swap(equal, copy.equal);
+   return *this;
+}
+
+/*******************************************
+ * HashTable :: clear
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+void HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> :: clear()
+{
+   if (cap == 0)
+      return;
+
+   for (int i = 0; i < cap; i++)
+      if (ctrl[i] >= 0)
+         slots[i].~Slot();
+   memset(ctrl, HASH_EMPTY, cap);
+   numItems = 0;
+   growthLeft = maxLoad(cap);
+}
+
+/*******************************************
+ * HashTable :: reserve
+ * The smallest power of two that holds n at
+ * the maximum load.
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+void HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> :: reserve(int n)
+   throw (const char *)
+{
+   if (n <= 0 || n <= numItems + growthLeft)
+      return;
+
+   int newCap = HASH_GROUP;
+   while (maxLoad(newCap) < n)
+      newCap *= 2;
+   if (newCap > cap)
+      rehash(newCap);
+}
+
+/*******************************************
+ * HashTable :: lookup
+ * Walk the groups on key's probe sequence.
+ * A group with an empty slot ends the search,
+ * since an insert would have stopped there.
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+template <class Q>
+int HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> :: lookup(const Q & key) const
+{
+   if (cap == 0)
+      return -1;
+
+   size_t h = mix(hasher(key));
+   signed char h2 = (signed char)(h & 0x7F);
+   int groupMask = cap / HASH_GROUP - 1;
+   int g = (int)(h >> 7) & groupMask;
+
+   // triangular steps visit every group when the count is a power of two
+   for (int step = 1; ; step++)
+   {
+      HashGroup group(ctrl + g * HASH_GROUP);
+      for (unsigned bits = group.match(h2); bits; bits &= bits - 1)
+      {
+         int i = g * HASH_GROUP + HashGroup::first(bits);
+         if (equal(KeyOf::key(slots[i]), key))
+            return i;
+      }
+      if (group.matchEmpty())
+         return -1;
+      g = (g + step) & groupMask;
+   }
+}
+
+/*******************************************
+ * HashTable :: findFree
+ * Same walk, stopping at the first empty or
+ * deleted slot.  There is always an empty
+ * slot, so this always stops.
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+int HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> :: findFree(size_t h) const
+{
+   int groupMask = cap / HASH_GROUP - 1;
+   int g = (int)(h >> 7) & groupMask;
+   for (int step = 1; ; step++)
+   {
+      unsigned bits = HashGroup(ctrl + g * HASH_GROUP).matchFree();
+      if (bits)
+         return g * HASH_GROUP + HashGroup::first(bits);
+      g = (g + step) & groupMask;
+   }
+}
+
+/*******************************************
+ * HashTable :: lookupOrInsert
+ * If the table is out of room we either
+ * grow it or, when it is mostly tombstones,
+ * rehash it in place to clear them out.
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+template <class Q, class Make>
+pair<int, bool> HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> ::
+lookupOrInsert(const Q & key, Make make) throw (const char *)
+{
+   int i = lookup(key);
+   if (i >= 0)
+      return pair<int, bool>(i, false);
+
+   size_t h = mix(hasher(key));
+   if (growthLeft == 0)
+   {
+      // key, or what make() copies, may live in a slot rehash() is
+      // about to free (m.insert(k, m.at(j))), so build the new item
+      // aside first and move it in afterwards
+      typename aligned_storage<sizeof(Slot), alignof(Slot)>::type aside;
+      make((void *)&aside);         // if this throws, nothing has changed
+      Slot & item = *(Slot *)&aside;
+      try
+      {
+         if (cap && numItems <= maxLoad(cap) / 2)
+            rehash(cap);
+         else
+            rehash(cap ? cap * 2 : HASH_GROUP);
+         i = findFree(h);
+         new ((void *)(slots + i)) Slot(std::move(item));
+      }
+      catch (...)
+      {
+         item.~Slot();
+         throw;
+      }
+      item.~Slot();
+   }
+   else
+   {
+      i = findFree(h);
+      make((void *)(slots + i));   // if this throws, nothing has changed
+   }
+
+   if (ctrl[i] == HASH_EMPTY)
+      growthLeft--;
+   ctrl[i] = (signed char)(h & 0x7F);
+   numItems++;
+   return pair<int, bool>(i, true);
+}
+
+/*******************************************
+ * HashTable :: eraseAt
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+void HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> :: eraseAt(int i)
+{
+   assert(i >= 0 && i < cap && ctrl[i] >= 0);
+   slots[i].~Slot();
+   numItems--;
+
+   // a group that still has an empty slot was never full, so no probe
+   // went past it and the slot needs no tombstone
+   if (HashGroup(ctrl + (i & ~(HASH_GROUP - 1))).matchEmpty())
+   {
+      ctrl[i] = HASH_EMPTY;
+      growthLeft++;
+   }
+   else
+      ctrl[i] = HASH_DELETED;
+}
+
+/*******************************************
+ * HashTable :: rehash
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+void HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> :: rehash(int newCap)
+   throw (const char *)
+{
+   signed char * oldCtrl = ctrl;
+   Slot * oldSlots = slots;
+   int oldCap = cap;
+
+   try
+   {
+      ctrl = new signed char[newCap];
+      slots = (Slot *)::operator new(sizeof(Slot) * newCap);
+   }
+   catch (std::bad_alloc)
+   {
+      if (ctrl != oldCtrl)
+         delete [] ctrl;
+      ctrl = oldCtrl;
+      slots = oldSlots;
+      throw "ERROR: Unable to allocate buffer";
+   }
+
+   cap = newCap;
+   memset(ctrl, HASH_EMPTY, cap);
+   for (int i = 0; i < oldCap; i++)
+      if (oldCtrl[i] >= 0)
+      {
+         size_t h = mix(hasher(KeyOf::key(oldSlots[i])));
+         int j = findFree(h);
+         ctrl[j] = (signed char)(h & 0x7F);
+         new ((void *)(slots + j)) Slot(std::move(oldSlots[i]));
+         oldSlots[i].~Slot();
+      }
+   growthLeft = maxLoad(cap) - numItems;
+
+   delete [] oldCtrl;
+   ::operator delete(oldSlots);
+}
+
+/*******************************************
+ * HashTable :: destroy
+ *******************************************/
+template <class Slot, class Key, class KeyOf, class Ref, class Hash, class Equal>
+void HashTable <Slot, Key, KeyOf, Ref, Hash, Equal> :: destroy()
+{
+   for (int i = 0; i < cap; i++)
+      if (ctrl[i] >= 0)
+         slots[i].~Slot();
+   delete [] ctrl;
+   ::operator delete(slots);
+   ctrl = NULL;
+   slots = NULL;
+   cap = numItems = growthLeft = 0;
+}
+
+#endif // HASHTABLE_H
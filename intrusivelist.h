@@ -0,0 +1,313 @@
+/***********************************************************************
+ * Header:
+ *    INTRUSIVE LIST
+ * Summary:
+ *    This contains the ListHook class and the IntrusiveList and
+ * IntrusiveListIterator class templates.  Instead of copying each item
+ * into a Node, the links live inside the user's own objects: give the
+ * class a ListHook member per list it can be on and name that member
+ * when declaring the list:
+ *
+ *    struct Session { ListHook idle; ListHook active; ... };
+ *    IntrusiveList <Session, &Session::idle>   idleSessions;
+ *    IntrusiveList <Session, &Session::active> activeSessions;
+ *
+ * Linking and unlinking never allocate, and an object can take itself
+ * off whatever list it is on with hook.unlink().  The list is circular
+ * around a sentinel hook, so there are no NULL checks at the ends.
+ * The List does not own the objects, it only links them.
+ * Author:
+ *    Ryan Walker
+ ************************************************************************/
+#ifndef INTRUSIVELIST_H
+#define INTRUSIVELIST_H
+
+#include <cstddef>
+#include <iostream>
+using namespace std;
+
+/************************************************
+ * ListHook
+ * The pNext/pPrev pair that goes inside an
+ * object.  An unlinked hook points at nothing.
+ ***********************************************/
+class ListHook
+{
+public:
+	ListHook * pNext;		// points to the next hook
+	ListHook * pPrev;		// points to the previous hook
+
+	// default constructor : not on any list
+	ListHook() : pNext(NULL), pPrev(NULL) {}
+
+	// copying an object does not put the copy on the same lists
+	ListHook(const ListHook &) : pNext(NULL), pPrev(NULL) {}
+	ListHook & operator = (const ListHook &) { return *this; }
+
+	// an object being destroyed takes itself off its list
+	~ListHook()						{ unlink(); }
+
+	// is this hook on a list?
+	bool linked() const			{ return pNext != NULL; }
+
+	// take this hook off whatever list it is on, O(1)
+	void unlink()
+	{
+		if (pNext)
+		{
+			pPrev->pNext = pNext;
+			pNext->pPrev = pPrev;
+			pNext = pPrev = NULL;
+		}
+	}
+
+	// put this hook in front of pos
+	void linkBefore(ListHook * pos)
+	{
+		pNext = pos;
+		pPrev = pos->pPrev;
+		pos->pPrev->pNext = this;
+		pos->pPrev = this;
+	}
+};
+
+// forward declaration for IntrusiveListIterator
+template <class T, ListHook T::*Hook>
+class IntrusiveListIterator;
+
+template <class T, ListHook T::*Hook>
+class IntrusiveList
+{
+public:
+	ListHook sentinel;	// pNext is the head, pPrev is the tail
+
+	// Default Constructor
+	IntrusiveList()			{ sentinel.pNext = sentinel.pPrev = &sentinel; }
+
+	// Destructor : unlinks everything, the objects are not ours
+	~IntrusiveList()			{ clear(); sentinel.pNext = sentinel.pPrev = NULL; }
+
+	// is this List empty?
+	bool empty() const 		{ return sentinel.pNext == &sentinel; }
+
+	// unlinks every object
+	void clear();
+
+	// counts the objects.  O(n), objects can leave without telling us
+	int size() const;
+
+	// link t onto the end of the List
+	void push_back(T & t)		{ link(t).linkBefore(&sentinel);        }
+
+	// link t onto the front of the List
+	void push_front(T & t)		{ link(t).linkBefore(sentinel.pNext);   }
+
+	// unlink the front object
+	void pop_front() throw (const char *);
+
+	// unlink the back object
+	void pop_back()  throw (const char *);
+
+	// returns the front object
+	T & front() throw (const char *);
+
+	// returns the back object
+	T & back()  throw (const char *);
+
+	// links t in front of it
+	void insert(IntrusiveListIterator<T, Hook> it, T & t) { link(t).linkBefore(it.p); }
+
+	// unlinks the object at it
+	void remove(IntrusiveListIterator<T, Hook> it) throw (const char *);
+
+	// unlinks t, wherever it is
+	static void erase(T & t)	{ (t.*Hook).unlink(); }
+
+	// iterates from the head of the List till it hits the sentinel
+	IntrusiveListIterator <T, Hook> begin()  { return IntrusiveListIterator <T, Hook>(sentinel.pNext); }
+
+	// iterates from the tail of the List till it hits the sentinel
+	IntrusiveListIterator <T, Hook> rbegin() { return IntrusiveListIterator <T, Hook>(sentinel.pPrev); }
+
+	// end of the List at the tail
+	IntrusiveListIterator <T, Hook> end()    { return IntrusiveListIterator <T, Hook>(&sentinel); }
+
+	// end of the List at the head
+	IntrusiveListIterator <T, Hook> rend()   { return IntrusiveListIterator <T, Hook>(&sentinel); }
+
+	// the object a hook lives in
+	static T * owner(ListHook * hook)
+	{
+		return reinterpret_cast<T *>(reinterpret_cast<char *>(hook) - offset());
+	}
+
+private:
+	// where the hook sits inside a T
+	static ptrdiff_t offset()
+	{
+		static char buffer[sizeof(T)];
+		T * t = reinterpret_cast<T *>(buffer);
+		return reinterpret_cast<char *>(&(t->*Hook)) - buffer;
+	}
+
+	// the hook of t, taken off any list it is already on
+	static ListHook & link(T & t)
+	{
+		ListHook & hook = t.*Hook;
+		hook.unlink();
+		return hook;
+	}
+
+	// the sentinel can't be copied, the hooks point at it
+	IntrusiveList(const IntrusiveList & rhs);
+	IntrusiveList & operator = (const IntrusiveList & rhs);
+};
+
+/************************************
+* IntrusiveList :: clear
+************************************/
+template <class T, ListHook T::*Hook>
+void IntrusiveList <T, Hook> :: clear()
+{
+	while (!empty())
+		sentinel.pNext->unlink();
+}
+
+/************************************
+* IntrusiveList :: size
+************************************/
+template <class T, ListHook T::*Hook>
+int IntrusiveList <T, Hook> :: size() const
+{
+	int count = 0;
+	for (const ListHook * p = sentinel.pNext; p != &sentinel; p = p->pNext)
+		count++;
+	return count;
+}
+
+/************************************
+* IntrusiveList :: pop_front
+************************************/
+template <class T, ListHook T::*Hook>
+void IntrusiveList <T, Hook> :: pop_front() throw (const char *)
+{
+	if (empty())
+		throw "ERROR: unable to pop from the front of an empty list";
+	sentinel.pNext->unlink();
+}
+
+/************************************
+* IntrusiveList :: pop_back
+************************************/
+template <class T, ListHook T::*Hook>
+void IntrusiveList <T, Hook> :: pop_back() throw (const char *)
+{
+	if (empty())
+		throw "ERROR: unable to pop from the back of an empty list";
+	sentinel.pPrev->unlink();
+}
+
+/************************************
+* IntrusiveList :: front
+************************************/
+template <class T, ListHook T::*Hook>
+T & IntrusiveList <T, Hook> :: front() throw (const char *)
+{
+	if (empty())
+		throw "ERROR: Unable to access data from an empty list";
+	return *owner(sentinel.pNext);
+}
+
+/************************************
+* IntrusiveList :: back
+************************************/
+template <class T, ListHook T::*Hook>
+T & IntrusiveList <T, Hook> :: back() throw (const char *)
+{
+	if (empty())
+		throw "ERROR: Unable to access data from an empty list";
+	return *owner(sentinel.pPrev);
+}
+
+/************************************
+* IntrusiveList :: remove
+************************************/
+template <class T, ListHook T::*Hook>
+void IntrusiveList <T, Hook> :: remove(IntrusiveListIterator<T, Hook> it) throw (const char *)
+{
+	if (it == end())
+		throw "ERROR: unable to remove from an invalid location in a list";
+	it.p->unlink();
+}
+
+/**************************************************
+ * INTRUSIVE LIST ITERATOR
+ * Walks the hooks and hands back the objects
+ *************************************************/
+template <class T, ListHook T::*Hook>
+class IntrusiveListIterator
+{
+  public:
+   // default constructor
+   IntrusiveListIterator() : p(NULL) {}
+
+   // initialize to direct p to some hook
+   IntrusiveListIterator(ListHook * p) : p(p) {}
+
+   // copy constructor
+   IntrusiveListIterator(const IntrusiveListIterator & rhs) { *this = rhs; }
+
+   friend class IntrusiveList<T, Hook>;
+
+   // assignment operator
+   IntrusiveListIterator & operator = (const IntrusiveListIterator & rhs)
+   {
+      this->p = rhs.p;
+      return *this;
+   }
+
+   // comparison operator
+   bool operator == (const IntrusiveListIterator & rhs) const
+   {
+      return rhs.p == this->p;
+   }
+
+   // not equals operator
+   bool operator != (const IntrusiveListIterator & rhs) const
+   {
+      return rhs.p != this->p;
+   }
+
+   // dereference operator
+   T & operator * ()
+   {
+      return *IntrusiveList<T, Hook>::owner(p);
+   }
+
+   // prefix increment
+   IntrusiveListIterator <T, Hook> & operator ++ ()
+   {
+      p = p->pNext;
+      return *this;
+   }
+
+   // postfix increment
+   IntrusiveListIterator <T, Hook> operator++(int postfix)
+   {
+      IntrusiveListIterator tmp(*this);
+      p = p->pNext;
+      return tmp;
+   }
+
+   // prefix decrement
+   IntrusiveListIterator <T, Hook> & operator --()
+   {
+      p = p->pPrev;
+      return *this;
+   }
+
+  private:
+   ListHook * p;
+};
+
+#endif // INTRUSIVELIST_H
@@ -7,7 +7,8 @@
  * The list is composed of Node class pointers that point to both the 
  * previous Node and next Node.  The head's previous pointer is NULL and
  * the tail's next pointer is NULL.  numItems keeps track of the number
- * of Nodes.
+ * of Nodes.  Every List has its own NodePool, so Nodes come out of
+ * contiguous slabs and clear() frees them a slab at a time.
  * Author:
  *    Ryan Walker
  ************************************************************************/
@@ -15,6 +16,7 @@
 #define LIST_H
 
 #include <iostream>
+#include <functional>
 #include "node.h"
 using namespace std;
 
@@ -30,12 +32,13 @@ public:
 	int numItems;		// number of Nodes in the List
 	Node<T> * head;	// front of the doubley linked-list
 	Node<T> * tail;	// tail of the doubley linked-list
+	NodePool<T> pool;	// where this List's Nodes come from
 
 	// Default Constructor
 	List() : numItems(0), head(NULL), tail(NULL) {}
   
 	// Copy Constructor
-	List(const List & rhs)
+	List(const List & rhs) : numItems(0), head(NULL), tail(NULL)
 	{
 	  	try
 	  	{
@@ -52,7 +55,7 @@ public:
 	bool empty() const 			{ return numItems == 0; }
 
 	// clears all List data and sets head and tail to NULL
-	void clear()					{ numItems = 0; freeData(head); tail = NULL; }
+	void clear()					{ numItems = 0; head = tail = NULL; pool.clear(); }
   	
   	// returns the number of Nodes in the List as an int
 	int size()						{ return numItems;		}
@@ -74,6 +77,22 @@ public:
 
 	// deletes a Node from the List
 	void remove(ListIterator<T> it);
+
+	// relinks the Node at it to the front of the List
+	void move_front(ListIterator<T> it);
+
+	// moves every Node of rhs in front of it, leaving rhs empty
+	void splice(ListIterator<T> it, List & rhs);
+
+	// merges the sorted rhs into this sorted List, leaving rhs empty
+	void merge(List & rhs)						{ merge(rhs, less<T>()); }
+	template <class Compare>
+	void merge(List & rhs, Compare comp);
+
+	// sorts the List by relinking Nodes, never copying data
+	void sort()										{ sort(less<T>()); }
+	template <class Compare>
+	void sort(Compare comp);
   
   	// assignment operator
 	List <T> & operator = (const List & rhs);
@@ -100,7 +119,7 @@ public:
 template <class T>
 void List <T> :: push_back(const T & data) throw (const char *)
 {
-	Node<T>* nNode = new Node<T>(data);
+	Node<T>* nNode = pool.alloc(data);
 	if (tail == NULL)
 	{
 		// initialize
@@ -133,7 +152,7 @@ void List <T> :: push_back(const T & data) throw (const char *)
 template <class T>
 void List <T> :: push_front(const T & data) throw (const char *)
 {
-	Node<T>* nNode = new Node<T>(data);
+	Node<T>* nNode = pool.alloc(data);
 	if (head == NULL)
 	{
 		// initialize
@@ -203,7 +222,7 @@ T & List <T> :: back() throw (const char *)
 template <class T>
 void List <T> :: insert(ListIterator <T> it, const T & data)
 {
-   Node<T> * nNode  =  new Node<T>(data);
+   Node<T> * nNode  =  pool.alloc(data);
    if (head == NULL)			// make a new List
 	{
       head = tail = nNode;
@@ -234,24 +253,13 @@ void List <T> :: insert(ListIterator <T> it, const T & data)
 template <class T>
 List <T> & List <T> :: operator = (const List & rhs)
 {
-	Node<T> *node = rhs.head;
-	Node<T> *copy = new Node<T>;
-	copy->data = node->data;
-	head = copy; // We do not loop through yet because we want to keep track of the head
-	node = node->pNext;
-
-	// Now we can loop through
-	while(node)
-	{
-		Node<T>* prev = copy;
-		copy->pNext = new Node<T>;
-		copy = copy->pNext;
-		copy->data = node->data;
-		copy->pPrev = prev;
-		node = node->pNext;
-	}
-	tail = copy;
-	numItems = rhs.numItems;
+	if (this == &rhs)
+		return *this;
+
+	// start over with a fresh pool, then copy the Nodes in order
+	clear();
+	for (Node<T> *node = rhs.head; node; node = node->pNext)
+		push_back(node->data);
 
 	// return *this as the copied List
 	return *this;
@@ -281,15 +289,221 @@ void List <T> :: remove(ListIterator<T> it)
 			else					// tail
 				tail = tail->pPrev;
 		}
-		else if (it.p->pPrev == NULL) // head
+		else if (it.p->pNext)	// head
 		{
 			it.p->pNext->pPrev = NULL;
 			head = head->pNext;
 		}
+		else						// the only Node
+		{
+			head = tail = NULL;
+		}
+		pool.free(it.p);	// the Node can be handed out again
 		numItems--;	// we're losing a node.
 	}
 }
 
+/************************************
+* List <T> :: move_front
+* Takes a ListIterator and moves its
+* Node to the head without copying or
+* allocating anything.
+************************************/
+template <class T>
+void List <T> :: move_front(ListIterator<T> it)
+{
+	Node<T> *node = it.p;
+	if (node == NULL || node == head)
+		return;
+
+	// take it out
+	node->pPrev->pNext = node->pNext;
+	if (node->pNext)
+		node->pNext->pPrev = node->pPrev;
+	else
+		tail = node->pPrev;
+
+	// put it at the front
+	node->pPrev = NULL;
+	node->pNext = head;
+	head->pPrev = node;
+	head = node;
+}
+
+/************************************
+* List <T> :: splice
+* Takes a ListIterator and another
+* List.  Relinks all of rhs's Nodes in
+* front of it in O(1) and takes over
+* rhs's NodePool, since those Nodes
+* live in its slabs.
+************************************/
+template <class T>
+void List <T> :: splice(ListIterator<T> it, List & rhs)
+{
+	if (this == &rhs || rhs.head == NULL)
+		return;
+
+	if (head == NULL)				// we were empty
+	{
+		head = rhs.head;
+		tail = rhs.tail;
+	}
+	else if (it == end())		// splice at end of list
+	{
+		tail->pNext = rhs.head;
+		rhs.head->pPrev = tail;
+		tail = rhs.tail;
+	}
+	else							// splice at beginning or middle
+	{
+		rhs.tail->pNext = it.p;
+		rhs.head->pPrev = it.p->pPrev;
+		if (it.p == head)
+			head = rhs.head;
+		else
+			it.p->pPrev->pNext = rhs.head;
+		it.p->pPrev = rhs.tail;
+	}
+
+	numItems += rhs.numItems;
+	pool.adopt(rhs.pool);
+	rhs.head = rhs.tail = NULL;
+	rhs.numItems = 0;
+}
+
+/************************************
+* List <T> :: merge
+* Both Lists must already be sorted by
+* comp.  Walks the two once, relinking
+* rhs's Nodes in between ours.  Equal
+* items keep ours first.
+************************************/
+template <class T>
+template <class Compare>
+void List <T> :: merge(List & rhs, Compare comp)
+{
+	if (this == &rhs || rhs.head == NULL)
+		return;
+
+	Node<T> *ours = head;
+	Node<T> *theirs = rhs.head;
+	Node<T> *last = NULL;		// end of the merged part
+
+	while (ours && theirs)
+	{
+		Node<T> *next;
+		if (comp(theirs->data, ours->data))
+		{
+			next = theirs;
+			theirs = theirs->pNext;
+		}
+		else
+		{
+			next = ours;
+			ours = ours->pNext;
+		}
+
+		next->pPrev = last;
+		if (last)
+			last->pNext = next;
+		else
+			head = next;
+		last = next;
+	}
+
+	// whatever is left is already linked together
+	Node<T> *rest = ours ? ours : theirs;
+	rest->pPrev = last;
+	if (last)
+		last->pNext = rest;
+	else
+		head = rest;
+	if (!ours)
+		tail = rhs.tail;
+
+	numItems += rhs.numItems;
+	pool.adopt(rhs.pool);
+	rhs.head = rhs.tail = NULL;
+	rhs.numItems = 0;
+}
+
+/************************************
+* List <T> :: sort
+* A bottom-up merge sort.  Each pass
+* merges runs of width 1, 2, 4, ...
+* following only pNext, and pPrev is
+* fixed up as the merged Nodes are
+* linked.  No allocation, no copies of
+* data, and it is stable.
+************************************/
+template <class T>
+template <class Compare>
+void List <T> :: sort(Compare comp)
+{
+	if (numItems < 2)
+		return;
+
+	Node<T> *list = head;
+	for (int width = 1; ; width *= 2)
+	{
+		Node<T> *p = list;
+		Node<T> *last = NULL;
+		int merges = 0;
+		list = NULL;
+
+		while (p)
+		{
+			merges++;
+
+			// q starts width Nodes after p
+			Node<T> *q = p;
+			int pSize = 0;
+			while (q && pSize < width)
+			{
+				q = q->pNext;
+				pSize++;
+			}
+			int qSize = width;
+
+			// merge the run at p with the run at q
+			while (pSize > 0 || (qSize > 0 && q))
+			{
+				Node<T> *next;
+				if (pSize == 0)
+				{
+					next = q; q = q->pNext; qSize--;
+				}
+				else if (qSize == 0 || q == NULL || !comp(q->data, p->data))
+				{
+					next = p; p = p->pNext; pSize--;
+				}
+				else
+				{
+					next = q; q = q->pNext; qSize--;
+				}
+
+				next->pPrev = last;
+				if (last)
+					last->pNext = next;
+				else
+					list = next;
+				last = next;
+			}
+
+			p = q;
+		}
+
+		last->pNext = NULL;
+		if (merges <= 1)	// one run left, it's sorted
+		{
+			head = list;
+			tail = last;
+			return;
+		}
+	}
+}
+
 template <class T>
 class ListIterator
 {
@@ -305,6 +519,8 @@ class ListIterator
 
    friend void List<T> :: insert(ListIterator<T> it, const T & data);
    friend void List<T> :: remove(ListIterator<T> it);
+   friend void List<T> :: splice(ListIterator<T> it, List<T> & rhs);
+   friend void List<T> :: move_front(ListIterator<T> it);
 
    // assignment operator
    ListIterator & operator = (const ListIterator & rhs)
@@ -0,0 +1,468 @@
+/***************************************************************
+ * File: lru.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the LruCache class and
+ *    the ShardedLruCache class.  The cache keeps its entries in
+ * a List, most recently used at the head, and finds them through
+ * an open-addressing hash index from key to Node.  A hit relinks
+ * the Node to the head and a miss that overflows the cache drops
+ * the tail, so get() and put() are both O(1).
+ ***************************************************************/
+#ifndef LRU_H
+#define LRU_H
+
+#include "list.h"
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <mutex>
+
+using namespace std;
+
+/************************************************
+ * LruEntry
+ * What the cache keeps in each List Node.  The
+ * hash is saved so the index never has to hash
+ * a key twice.
+ ***********************************************/
+template <class K, class V>
+struct LruEntry
+{
+   K key;
+   V value;
+   size_t hash;      // hash of key
+   size_t bytes;     // what this entry counts against the byte limit
+};
+
+/************************************************
+ * LruCache
+ * Bounded by a number of entries, a number of
+ * bytes, or both (0 means no limit).  onEvict is
+ * called for every entry pushed out to make room.
+ ***********************************************/
+template <class K, class V, class Hash = hash<K> >
+class LruCache
+{
+public:
+   typedef LruEntry<K, V> Entry;
+
+   // non-default constructor : how many entries and/or bytes to hold
+   LruCache(int maxEntries, size_t maxBytes = 0);
+
+   // destructor : free the index (the List frees itself)
+   ~LruCache()          { delete [] slots; }
+
+   // how big an entry is, for the byte limit.  Defaults to sizeof(K) + sizeof(V).
+   function<size_t (const K &, const V &)> sizeOf;
+
+   // called with each entry evicted to make room
+   function<void (const K &, const V &)> onEvict;
+
+   // Is the cache empty?
+   bool empty() const   { return entries.empty(); }
+
+   // Number of entries in the cache
+   int size() const     { return entries.numItems; }
+
+   // Bytes counted against the byte limit
+   size_t bytes() const { return numBytes; }
+
+   // look up key and mark it most recently used
+   bool get(const K & key, V & value);
+
+   // add or replace key as the most recently used
+   void put(const K & key, const V & value) throw (const char *);
+
+   // drop key if it is there (no eviction callback)
+   bool erase(const K & key);
+
+   // drop everything (no eviction callback)
+   void clear();
+
+private:
+   // slot holding key, or the empty slot where it would go
+   int probe(const K & key, size_t h) const;
+
+   // take the Node in slot i out of the index
+   void unindex(int i);
+
+   // double the index
+   void grow();
+
+   // evict from the tail until we are within the limits
+   void trim();
+
+   List<Entry> entries;     // most recently used first
+   Node<Entry> ** slots;    // the hash index, NULL is empty
+   int slotCap;             // always a power of two
+   int maxEntries;
+   size_t maxBytes;
+   size_t numBytes;
+   Hash hasher;
+
+   // no copying, the index points into entries
+   LruCache(const LruCache & rhs);
+   LruCache & operator = (const LruCache & rhs);
+};
+
+/*******************************************
+ * LruCache :: NON-DEFAULT CONSTRUCTOR
+ * Sizes the index for maxEntries at half full
+ * so a bounded cache never rehashes.
+ *******************************************/
+template <class K, class V, class Hash>
+LruCache <K, V, Hash> :: LruCache(int maxEntries, size_t maxBytes)
+   : slots(NULL), slotCap(16), maxEntries(maxEntries),
+     maxBytes(maxBytes), numBytes(0)
+{
+   assert(maxEntries >= 0);
+   while (slotCap < maxEntries * 2)
+      slotCap *= 2;
+
+   slots = new Node<Entry> * [slotCap];
+   for (int i = 0; i < slotCap; i++)
+      slots[i] = NULL;
+}
+
+/*******************************************
+ * LruCache :: probe
+ * Linear probing from the key's home slot.
+ *******************************************/
+template <class K, class V, class Hash>
+int LruCache <K, V, Hash> :: probe(const K & key, size_t h) const
+{
+   int mask = slotCap - 1;
+   int i = (int)(h & mask);
+   while (slots[i] &&
+          !(slots[i]->data.hash == h && slots[i]->data.key == key))
+      i = (i + 1) & mask;
+   return i;
+}
+
+/*******************************************
+ * LruCache :: unindex
+ * Backward-shift delete: slide later members
+ * of the probe run into the hole so no
+ * tombstones are needed.
+ *******************************************/
+template <class K, class V, class Hash>
+void LruCache <K, V, Hash> :: unindex(int i)
+{
+   int mask = slotCap - 1;
+   slots[i] = NULL;
+
+   for (int j = (i + 1) & mask; slots[j]; j = (j + 1) & mask)
+   {
+      int home = (int)(slots[j]->data.hash & mask);
+
+      // can slots[j] move back to i without passing its home?
+      bool move = (i <= j) ? (home <= i || home > j)
+                           : (home <= i && home > j);
+      if (move)
+      {
+         slots[i] = slots[j];
+         slots[j] = NULL;
+         i = j;
+      }
+   }
+}
+
+/*******************************************
+ * LruCache :: grow
+ * Only needed when there is no entry limit.
+ *******************************************/
+template <class K, class V, class Hash>
+void LruCache <K, V, Hash> :: grow()
+{
+   delete [] slots;
+   slotCap *= 2;
+   slots = new Node<Entry> * [slotCap];
+   for (int i = 0; i < slotCap; i++)
+      slots[i] = NULL;
+
+   for (Node<Entry> * node = entries.head; node; node = node->pNext)
+      slots[probe(node->data.key, node->data.hash)] = node;
+}
+
+/*******************************************
+ * LruCache :: trim
+ * An entry bigger than maxBytes on its own is
+ * evicted too, so the limit always holds.
+ *******************************************/
+template <class K, class V, class Hash>
+void LruCache <K, V, Hash> :: trim()
+{
+   while (!entries.empty() &&
+          ((maxEntries && entries.numItems > maxEntries) ||
+           (maxBytes && numBytes > maxBytes)))
+   {
+      Node<Entry> * victim = entries.tail;
+      unindex(probe(victim->data.key, victim->data.hash));
+      numBytes -= victim->data.bytes;
+      if (onEvict)
+         onEvict(victim->data.key, victim->data.value);
+      entries.remove(ListIterator<Entry>(victim));
+   }
+}
+
+/*******************************************
+ * LruCache :: get
+ *******************************************/
+template <class K, class V, class Hash>
+bool LruCache <K, V, Hash> :: get(const K & key, V & value)
+{
+   Node<Entry> * node = slots[probe(key, hasher(key))];
+   if (node == NULL)
+      return false;
+
+   entries.move_front(ListIterator<Entry>(node));
+   value = node->data.value;
+   return true;
+}
+
+/*******************************************
+ * LruCache :: put
+ *******************************************/
+template <class K, class V, class Hash>
+void LruCache <K, V, Hash> :: put(const K & key, const V & value) throw (const char *)
+{
+   size_t h = hasher(key);
+   size_t b = sizeOf ? sizeOf(key, value) : sizeof(K) + sizeof(V);
+   int i = probe(key, h);
+
+   if (slots[i])
+   {
+      // already here, replace the value and freshen it
+      Node<Entry> * node = slots[i];
+      numBytes += b - node->data.bytes;
+      node->data.value = value;
+      node->data.bytes = b;
+      entries.move_front(ListIterator<Entry>(node));
+   }
+   else
+   {
+      Entry entry;
+      entry.key = key;
+      entry.value = value;
+      entry.hash = h;
+      entry.bytes = b;
+      entries.push_front(entry);
+      slots[i] = entries.head;
+      numBytes += b;
+
+      if (entries.numItems * 2 > slotCap)
+         grow();
+   }
+
+   trim();
+}
+
+/*******************************************
+ * LruCache :: erase
+ *******************************************/
+template <class K, class V, class Hash>
+bool LruCache <K, V, Hash> :: erase(const K & key)
+{
+   int i = probe(key, hasher(key));
+   Node<Entry> * node = slots[i];
+   if (node == NULL)
+      return false;
+
+   unindex(i);
+   numBytes -= node->data.bytes;
+   entries.remove(ListIterator<Entry>(node));
+   return true;
+}
+
+/*******************************************
+ * LruCache :: clear
+ *******************************************/
+template <class K, class V, class Hash>
+void LruCache <K, V, Hash> :: clear()
+{
+   entries.clear();
+   for (int i = 0; i < slotCap; i++)
+      slots[i] = NULL;
+   numBytes = 0;
+}
+
+/************************************************
+ * ShardedLruCache
+ * numShards LruCaches, each behind its own
+ * mutex, picked by the high bits of the hash so
+ * threads working on different keys rarely wait
+ * on each other.  Recency is kept per shard.
+ ***********************************************/
+template <class K, class V, class Hash = hash<K> >
+class ShardedLruCache
+{
+public:
+   // non-default constructor : the limits are split evenly over the shards,
+   // with no more shards than there are entries (or bytes) to share out
+   ShardedLruCache(int maxEntries, size_t maxBytes = 0, int numShards = 16);
+
+   // destructor : free the shards
+   ~ShardedLruCache();
+
+   // the same on every shard
+   void setSizeOf(const function<size_t (const K &, const V &)> & sizeOf);
+   void setOnEvict(const function<void (const K &, const V &)> & onEvict);
+
+   // Number of entries over all shards
+   int size() const;
+
+   // the LruCache operations, locked per shard
+   bool get(const K & key, V & value);
+   void put(const K & key, const V & value) throw (const char *);
+   bool erase(const K & key);
+   void clear();
+
+private:
+   // which shard key belongs to.  The shard's slots are picked by
+   // the low bits of the hash, so the shard comes from the high bits
+   // of a mix of it, scaled onto [0, numShards) as in BloomFilter.
+   int shardOf(const K & key) const
+   {
+      unsigned long long m = (unsigned long long)hasher(key) * 0x9E3779B97F4A7C15ULL;
+      return (int)(((m >> 32) * (unsigned long long)numShards) >> 32);
+   }
+
+   LruCache<K, V, Hash> ** shards;
+   mutex * locks;
+   int numShards;
+   Hash hasher;
+
+   // no copying
+   ShardedLruCache(const ShardedLruCache & rhs);
+   ShardedLruCache & operator = (const ShardedLruCache & rhs);
+};
+
+/*******************************************
+ * ShardedLruCache :: NON-DEFAULT CONSTRUCTOR
+ *******************************************/
+template <class K, class V, class Hash>
+ShardedLruCache <K, V, Hash> :: ShardedLruCache(int maxEntries, size_t maxBytes,
+                                                int numShards)
+   : numShards(numShards < 1 ? 1 : numShards)
+{
+   // a shard with a zero share would have no limit at all
+   if (maxEntries && maxEntries < this->numShards)
+      this->numShards = maxEntries;
+   if (maxBytes && maxBytes < (size_t)this->numShards)
+      this->numShards = (int)maxBytes;
+
+   // the first (max % numShards) shards take one extra, so the
+   // shards add up to exactly the limits
+   int perEntries = maxEntries / this->numShards;
+   int extraEntries = maxEntries % this->numShards;
+   size_t perBytes = maxBytes / this->numShards;
+   size_t extraBytes = maxBytes % this->numShards;
+
+   shards = new LruCache<K, V, Hash> * [this->numShards];
+   locks = new mutex[this->numShards];
+   for (int i = 0; i < this->numShards; i++)
+      shards[i] = new LruCache<K, V, Hash>(perEntries + (i < extraEntries),
+                                           perBytes + (i < extraBytes));
+}
+
+/*******************************************
+ * ShardedLruCache :: DESTRUCTOR
+ *******************************************/
+template <class K, class V, class Hash>
+ShardedLruCache <K, V, Hash> :: ~ShardedLruCache()
+{
+   for (int i = 0; i < numShards; i++)
+      delete shards[i];
+   delete [] shards;
+   delete [] locks;
+}
+
+/*******************************************
+ * ShardedLruCache :: setSizeOf
+ *******************************************/
+template <class K, class V, class Hash>
+void ShardedLruCache <K, V, Hash> :: setSizeOf(const function<size_t (const K &, const V &)> & sizeOf)
+{
+   for (int i = 0; i < numShards; i++)
+   {
+      lock_guard<mutex> lock(locks[i]);
+      shards[i]->sizeOf = sizeOf;
+   }
+}
+
+/*******************************************
+ * ShardedLruCache :: setOnEvict
+ *******************************************/
+template <class K, class V, class Hash>
+void ShardedLruCache <K, V, Hash> :: setOnEvict(const function<void (const K &, const V &)> & onEvict)
+{
+   for (int i = 0; i < numShards; i++)
+   {
+      lock_guard<mutex> lock(locks[i]);
+      shards[i]->onEvict = onEvict;
+   }
+}
+
+/*******************************************
+ * ShardedLruCache :: size
+ *******************************************/
+template <class K, class V, class Hash>
+int ShardedLruCache <K, V, Hash> :: size() const
+{
+   int total = 0;
+   for (int i = 0; i < numShards; i++)
+   {
+      lock_guard<mutex> lock(locks[i]);
+      total += shards[i]->size();
+   }
+   return total;
+}
+
+/*******************************************
+ * ShardedLruCache :: get
+ *******************************************/
+template <class K, class V, class Hash>
+bool ShardedLruCache <K, V, Hash> :: get(const K & key, V & value)
+{
+   int s = shardOf(key);
+   lock_guard<mutex> lock(locks[s]);
+   return shards[s]->get(key, value);
+}
+
+/*******************************************
+ * ShardedLruCache :: put
+ *******************************************/
+template <class K, class V, class Hash>
+void ShardedLruCache <K, V, Hash> :: put(const K & key, const V & value) throw (const char *)
+{
+   int s = shardOf(key);
+   lock_guard<mutex> lock(locks[s]);
+   shards[s]->put(key, value);
+}
+
+/*******************************************
+ * ShardedLruCache :: erase
+ *******************************************/
+template <class K, class V, class Hash>
+bool ShardedLruCache <K, V, Hash> :: erase(const K & key)
+{
+   int s = shardOf(key);
+   lock_guard<mutex> lock(locks[s]);
+   return shards[s]->erase(key);
+}
+
+/*******************************************
+ * ShardedLruCache :: clear
+ *******************************************/
+template <class K, class V, class Hash>
+void ShardedLruCache <K, V, Hash> :: clear()
+{
+   for (int i = 0; i < numShards; i++)
+   {
+      lock_guard<mutex> lock(locks[i]);
+      shards[i]->clear();
+   }
+}
+
+#endif // LRU_H
@@ -0,0 +1,359 @@
+/***************************************************************
+ * File: minmaxheap.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the MinMaxHeap class.
+ *    A double-ended priority queue kept in one contiguous array
+ * using the same child math as heap.h (2i + 1, 2i + 2).  Even
+ * levels are ordered as a min heap and odd levels as a max heap,
+ * so both the smallest and the largest item are always within
+ * the first three slots.
+ ***************************************************************/
+#ifndef MINMAXHEAP_H
+#define MINMAXHEAP_H
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/************************************************
+ * MinMaxHeap
+ * min() and max() are O(1), push(), pop_min() and
+ * pop_max() are O(log n).
+ ***********************************************/
+template <class T>
+class MinMaxHeap
+{
+public:
+
+   vector<T> data;     // the heap, level by level
+
+   // default constructor : empty and kinda useless
+   MinMaxHeap() {}
+
+   // non-default constructor : pre-allocate
+   MinMaxHeap(int cap) { data.reserve(cap); }
+
+   // Is the heap empty?
+   bool empty() const   { return data.empty();     }
+
+   // Number of items within the heap
+   int size()   const   { return (int)data.size(); }
+
+   // Clears the heap of items, not capacity
+   void clear()         { data.clear();            }
+
+   // Adds an item to the heap
+   void push(const T & t) throw (const char *);
+
+   // Returns the smallest item
+   const T & min() const throw (const char *);
+
+   // Returns the largest item
+   const T & max() const throw (const char *);
+
+   // Removes the smallest item
+   void pop_min() throw (const char *);
+
+   // Removes the largest item
+   void pop_max() throw (const char *);
+
+   // Replaces the smallest item with t if t is bigger.  Used to keep
+   // a bounded "best N" buffer: returns true if t was kept.
+   bool replace_min(const T & t) throw (const char *);
+
+   // Replaces the largest item with t if t is smaller.
+   bool replace_max(const T & t) throw (const char *);
+
+private:
+   // is this index on a min level?
+   static bool isMinLevel(int i);
+
+   // index of the largest item
+   int maxIndex() const;
+
+   // percolate a new item up from the bottom
+   void bubbleUp(int i);
+   void bubbleUpMin(int i);
+   void bubbleUpMax(int i);
+
+   // percolate an item down from index i
+   void trickleDownMin(int i);
+   void trickleDownMax(int i);
+};
+
+/*******************************************
+ * MinMaxHeap :: isMinLevel
+ * Level 0 (the root) is a min level, level 1
+ * is a max level, and so on.
+ *******************************************/
+template <class T>
+bool MinMaxHeap <T> :: isMinLevel(int i)
+{
+   int level = 0;
+   for (i++; i > 1; i >>= 1)
+      level++;
+   return (level % 2) == 0;
+}
+
+/*******************************************
+ * MinMaxHeap :: maxIndex
+ * The largest item is one of the root's two
+ * children, or the root if it is alone.
+ *******************************************/
+template <class T>
+int MinMaxHeap <T> :: maxIndex() const
+{
+   if (data.size() == 1)
+      return 0;
+   if (data.size() == 2 || data[1] > data[2])
+      return 1;
+   return 2;
+}
+
+/*******************************************
+ * MinMaxHeap :: min
+ *******************************************/
+template <class T>
+const T & MinMaxHeap <T> :: min() const throw (const char *)
+{
+   if (data.empty())
+      throw "ERROR: Unable to reference the element from an empty heap";
+   return data[0];
+}
+
+/*******************************************
+ * MinMaxHeap :: max
+ *******************************************/
+template <class T>
+const T & MinMaxHeap <T> :: max() const throw (const char *)
+{
+   if (data.empty())
+      throw "ERROR: Unable to reference the element from an empty heap";
+   return data[maxIndex()];
+}
+
+/*****************************************
+ * MinMaxHeap :: push
+ * Adds an item to the bottom of the heap and
+ * lets it float up to the right level.
+ *****************************************/
+template <class T>
+void MinMaxHeap <T> :: push(const T & t) throw (const char *)
+{
+   try
+   {
+      data.push_back(t);
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate a new buffer for heap";
+   }
+
+   bubbleUp(size() - 1);
+}
+
+/*******************************************
+ * MinMaxHeap :: pop_min
+ * Moves the last item into the root and
+ * percolates it down.
+ *******************************************/
+template <class T>
+void MinMaxHeap <T> :: pop_min() throw (const char *)
+{
+   if (data.empty())
+      throw "ERROR: Unable to pop from an empty heap";
+
+   data[0] = data.back();
+   data.pop_back();
+   if (!data.empty())
+      trickleDownMin(0);
+}
+
+/*******************************************
+ * MinMaxHeap :: pop_max
+ * Moves the last item into the max slot and
+ * percolates it down.
+ *******************************************/
+template <class T>
+void MinMaxHeap <T> :: pop_max() throw (const char *)
+{
+   if (data.empty())
+      throw "ERROR: Unable to pop from an empty heap";
+
+   int i = maxIndex();
+   data[i] = data.back();
+   data.pop_back();
+   if (i < size())
+      trickleDownMax(i);
+}
+
+/*******************************************
+ * MinMaxHeap :: replace_min
+ * Overwrites the smallest item in place so a
+ * full buffer costs one percolation, not two.
+ *******************************************/
+template <class T>
+bool MinMaxHeap <T> :: replace_min(const T & t) throw (const char *)
+{
+   if (data.empty())
+      throw "ERROR: Unable to replace in an empty heap";
+   if (!(t > data[0]))
+      return false;
+
+   data[0] = t;
+   trickleDownMin(0);
+   return true;
+}
+
+/*******************************************
+ * MinMaxHeap :: replace_max
+ *******************************************/
+template <class T>
+bool MinMaxHeap <T> :: replace_max(const T & t) throw (const char *)
+{
+   if (data.empty())
+      throw "ERROR: Unable to replace in an empty heap";
+
+   int i = maxIndex();
+   if (!(t < data[i]))
+      return false;
+
+   data[i] = t;
+   trickleDownMax(i);
+   return true;
+}
+
+/*******************************************
+ * MinMaxHeap :: bubbleUp
+ * Decides which kind of level the new item
+ * belongs on, then floats it up through the
+ * grandparents of that kind.
+ *******************************************/
+template <class T>
+void MinMaxHeap <T> :: bubbleUp(int i)
+{
+   if (i == 0)
+      return;
+
+   int parent = (i - 1) / 2;
+   if (isMinLevel(i))
+   {
+      if (data[i] > data[parent])
+      {
+         swap(data[i], data[parent]);
+         bubbleUpMax(parent);
+      }
+      else
+         bubbleUpMin(i);
+   }
+   else
+   {
+      if (data[i] < data[parent])
+      {
+         swap(data[i], data[parent]);
+         bubbleUpMin(parent);
+      }
+      else
+         bubbleUpMax(i);
+   }
+}
+
+/*******************************************
+ * MinMaxHeap :: bubbleUpMin
+ *******************************************/
+template <class T>
+void MinMaxHeap <T> :: bubbleUpMin(int i)
+{
+   // grandparent is ((i - 1) / 2 - 1) / 2
+   while (i > 2)
+   {
+      int grand = (i - 3) / 4;
+      if (!(data[i] < data[grand]))
+         break;
+      swap(data[i], data[grand]);
+      i = grand;
+   }
+}
+
+/*******************************************
+ * MinMaxHeap :: bubbleUpMax
+ *******************************************/
+template <class T>
+void MinMaxHeap <T> :: bubbleUpMax(int i)
+{
+   while (i > 2)
+   {
+      int grand = (i - 3) / 4;
+      if (!(data[i] > data[grand]))
+         break;
+      swap(data[i], data[grand]);
+      i = grand;
+   }
+}
+
+/*******************************************
+ * MinMaxHeap :: trickleDownMin
+ * Finds the smallest child or grandchild.  A
+ * grandchild is swapped and then checked
+ * against its max-level parent.
+ *******************************************/
+template <class T>
+void MinMaxHeap <T> :: trickleDownMin(int i)
+{
+   int num = size();
+   while (2 * i + 1 < num)
+   {
+      // smallest of the children and grandchildren
+      int m = 2 * i + 1;
+      int candidates[5] = { 2 * i + 2, 4 * i + 3, 4 * i + 4, 4 * i + 5, 4 * i + 6 };
+      for (int c = 0; c < 5; c++)
+         if (candidates[c] < num && data[candidates[c]] < data[m])
+            m = candidates[c];
+
+      if (!(data[m] < data[i]))
+         return;
+
+      swap(data[i], data[m]);
+      if (m <= 2 * i + 2)
+         return; // a child has no children of its own to fix
+
+      int parent = (m - 1) / 2;
+      if (data[m] > data[parent])
+         swap(data[m], data[parent]);
+      i = m;
+   }
+}
+
+/*******************************************
+ * MinMaxHeap :: trickleDownMax
+ *******************************************/
+template <class T>
+void MinMaxHeap <T> :: trickleDownMax(int i)
+{
+   int num = size();
+   while (2 * i + 1 < num)
+   {
+      // largest of the children and grandchildren
+      int m = 2 * i + 1;
+      int candidates[5] = { 2 * i + 2, 4 * i + 3, 4 * i + 4, 4 * i + 5, 4 * i + 6 };
+      for (int c = 0; c < 5; c++)
+         if (candidates[c] < num && data[candidates[c]] > data[m])
+            m = candidates[c];
+
+      if (!(data[m] > data[i]))
+         return;
+
+      swap(data[i], data[m]);
+      if (m <= 2 * i + 2)
+         return;
+
+      int parent = (m - 1) / 2;
+      if (data[m] < data[parent])
+         swap(data[m], data[parent]);
+      i = m;
+   }
+}
+
+#endif // MINMAXHEAP_H
@@ -0,0 +1,324 @@
+/***************************************************************
+ * File: multiway.h
+ * Author: Ryan Walker
+ * Purpose: Contains the Intersection and Union classes.  They
+ *    run one query over any number of sorted lists (Sets, Vectors
+ * kept in order, or plain arrays) at once, instead of chaining
+ * && or || two lists at a time.  Nothing is computed up front.
+ * begin() hands back an iterator that finds each answer as it is
+ * asked for, so a query that only wants the first k answers stops
+ * after k.
+ *
+ *    An intersection is driven by its shortest list.  Each of its
+ * items is looked for in the next shortest list with a gallop (see
+ * setops.h) from where the last search stopped.  The first list
+ * that doesn't have it names a new candidate, and the shortest list
+ * gallops ahead to that.  The work is about the size of the
+ * shortest list times the log of the gaps, however long the others
+ * are.
+ *
+ *    A union merges the lists through a MinMaxHeap of their fronts.
+ *
+ *    The lists are only referenced, not copied, so they must
+ * outlive the query and not change under it.
+ ***************************************************************/
+#ifndef MULTIWAY_H
+#define MULTIWAY_H
+
+#include "minmaxheap.h"
+#include "set.h"
+#include "setops.h"
+#include "vector.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+using namespace std;
+
+/************************************************
+ * SortedRun
+ * One input list: num sorted items, no repeats.
+ ***********************************************/
+template <class T>
+struct SortedRun
+{
+   const T * data;
+   int num;
+
+   bool operator < (const SortedRun & rhs) const { return num < rhs.num; }
+};
+
+/************************************************
+ * MultiwayIterator
+ * Walks a query's cursor.  The end iterator is
+ * the one with no cursor.  It is an input
+ * iterator, so Set <T> (q.begin(), q.end())
+ * collects the answers.
+ ***********************************************/
+template <class Cursor>
+class MultiwayIterator
+{
+public:
+   typedef input_iterator_tag iterator_category;
+   typedef typename Cursor::value_type value_type;
+   typedef ptrdiff_t difference_type;
+   typedef const value_type * pointer;
+   typedef const value_type & reference;
+
+   // the end
+   MultiwayIterator() : atEnd(true) {}
+
+   // the beginning
+   MultiwayIterator(const Cursor & c) : cursor(c), atEnd(!c.valid()) {}
+
+   // only good against end()
+   bool operator != (const MultiwayIterator & rhs) const { return atEnd != rhs.atEnd; }
+   bool operator == (const MultiwayIterator & rhs) const { return atEnd == rhs.atEnd; }
+
+   // dereference operator
+   const value_type & operator * () const { return cursor.value(); }
+
+   // prefix increment
+   MultiwayIterator & operator ++ ()
+   {
+      cursor.next();
+      atEnd = !cursor.valid();
+      return *this;
+   }
+
+   // postfix increment, which is only good for *it++
+   value_type operator ++ (int)
+   {
+      value_type tmp = cursor.value();
+      ++(*this);
+      return tmp;
+   }
+
+private:
+   Cursor cursor;
+   bool atEnd;
+};
+
+/************************************************
+ * MultiwayQuery
+ * What Intersection and Union share: the lists
+ * and the limit on how many answers to give.
+ ***********************************************/
+template <class T>
+class MultiwayQuery
+{
+public:
+   // at most limit answers, 0 for all of them
+   MultiwayQuery(int limit = 0) : limit(limit) {}
+
+   // add an input list
+   void add(const Set <T> & set)           { add(set.data, set.numItems); }
+   void add(const Vector <T> & sorted)     { add(sorted.data, sorted.numItems); }
+   void add(const T * data, int num)
+   {
+      assert(num >= 0);
+      SortedRun <T> run = { data, num };
+      runs.push_back(run);
+   }
+
+   // how many lists?
+   int size() const                        { return (int)runs.size(); }
+
+   // start over with no lists
+   void clear()                            { runs.clear(); }
+
+   int limit;
+
+protected:
+   vector< SortedRun <T> > runs;
+};
+
+/************************************************
+ * IntersectCursor
+ * Items in every list.
+ ***********************************************/
+template <class T>
+class IntersectCursor
+{
+public:
+   typedef T value_type;
+
+   IntersectCursor() : limit(0), found(0), done(true) {}
+   IntersectCursor(const vector< SortedRun <T> > & unsorted, int limit)
+      : runs(unsorted), pos(unsorted.size(), 0), limit(limit), found(0),
+        done(unsorted.empty())
+   {
+      // shortest first: it drives, and the next shortest say no soonest
+      std::sort(runs.begin(), runs.end());
+      align();
+   }
+
+   bool valid() const        { return !done; }
+   const T & value() const   { return runs[0].data[pos[0]]; }
+
+   void next()
+   {
+      if (limit && ++found >= limit)
+      {
+         done = true;
+         return;
+      }
+      pos[0]++;
+      align();
+   }
+
+private:
+   // move forward to the next item every list has
+   void align()
+   {
+      int n = (int)runs.size();
+      while (!done)
+      {
+         if (pos[0] >= runs[0].num)
+         {
+            done = true;
+            return;
+         }
+         const T & candidate = runs[0].data[pos[0]];
+
+         int i;
+         for (i = 1; i < n; i++)
+         {
+            pos[i] = gallop(runs[i].data, pos[i], runs[i].num, candidate);
+            if (pos[i] == runs[i].num)
+            {
+               done = true;
+               return;
+            }
+            if (candidate < runs[i].data[pos[i]])
+               break;
+         }
+         if (i == n)
+            return; // everyone has it
+
+         // list i skipped past candidate, so nothing before
+         // what it has now can be an answer
+         pos[0] = gallop(runs[0].data, pos[0] + 1, runs[0].num, runs[i].data[pos[i]]);
+      }
+   }
+
+   vector< SortedRun <T> > runs;
+   vector<int> pos;          // where each list is
+   int limit;
+   int found;
+   bool done;
+};
+
+/************************************************
+ * UnionHead
+ * A list's front item in the union's heap.
+ ***********************************************/
+template <class T>
+struct UnionHead
+{
+   T value;
+   int run;
+
+   bool operator < (const UnionHead & rhs) const { return value < rhs.value; }
+   bool operator > (const UnionHead & rhs) const { return rhs.value < value; }
+};
+
+/************************************************
+ * UnionCursor
+ * Items in any list, once each.
+ ***********************************************/
+template <class T>
+class UnionCursor
+{
+public:
+   typedef T value_type;
+
+   UnionCursor() : limit(0), found(0) {}
+   UnionCursor(const vector< SortedRun <T> > & runs, int limit)
+      : runs(runs), pos(runs.size(), 0), heap((int)runs.size()),
+        limit(limit), found(0)
+   {
+      for (int i = 0; i < (int)runs.size(); i++)
+         if (runs[i].num)
+         {
+            UnionHead <T> head = { runs[i].data[0], i };
+            heap.push(head);
+         }
+   }
+
+   bool valid() const        { return !heap.empty(); }
+   const T & value() const   { return heap.min().value; }
+
+   // advance every list whose front is the current item
+   void next()
+   {
+      if (limit && ++found >= limit)
+      {
+         heap.clear();
+         return;
+      }
+
+      T current = heap.min().value;
+      while (!heap.empty() && !(current < heap.min().value))
+      {
+         int i = heap.min().run;
+         if (++pos[i] < runs[i].num)
+         {
+            UnionHead <T> head = { runs[i].data[pos[i]], i };
+            heap.replace_min(head);
+         }
+         else
+            heap.pop_min();
+      }
+   }
+
+private:
+   vector< SortedRun <T> > runs;
+   vector<int> pos;
+   MinMaxHeap< UnionHead <T> > heap;
+   int limit;
+   int found;
+};
+
+/************************************************
+ * Intersection
+ * Add the lists, then walk begin() to end().
+ ***********************************************/
+template <class T>
+class Intersection : public MultiwayQuery <T>
+{
+public:
+   typedef MultiwayIterator< IntersectCursor <T> > iterator;
+
+   Intersection(int limit = 0) : MultiwayQuery <T> (limit) {}
+
+   iterator begin() const
+   {
+      return iterator(IntersectCursor <T> (this->runs, this->limit));
+   }
+   iterator end() const       { return iterator(); }
+};
+
+/************************************************
+ * Union
+ * Add the lists, then walk begin() to end().
+ ***********************************************/
+template <class T>
+class Union : public MultiwayQuery <T>
+{
+public:
+   typedef MultiwayIterator< UnionCursor <T> > iterator;
+
+   Union(int limit = 0) : MultiwayQuery <T> (limit) {}
+
+   iterator begin() const
+   {
+      return iterator(UnionCursor <T> (this->runs, this->limit));
+   }
+   iterator end() const       { return iterator(); }
+};
+
+#endif // MULTIWAY_H
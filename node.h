@@ -18,14 +18,207 @@ public:
 
    T data;				// holds the data
    Node<T>* pNext;	// points to the next node
+   Node<T>* pPrev;	// points to the previous node (used by List)
 
    // default constructor : empty and kinda useless
-   Node() : pNext(NULL) {};
+   Node() : pNext(NULL), pPrev(NULL) {};
    
    // non-default constructor : create a new node with the data
-   Node(T nData) { this->data = nData; pNext = NULL; }
+   Node(T nData) { this->data = nData; pNext = NULL; pPrev = NULL; }
 };
 
+/************************************************
+ * NodePool
+ * Hands out Nodes from contiguous slabs instead of
+ * one new per Node.  Nodes given back go on a free
+ * list (threaded through pNext) and are handed out
+ * again first.  clear() gives back every Node at
+ * once by freeing the slabs, one delete per slab.
+ ***********************************************/
+template <class T>
+class NodePool
+{
+public:
+   Node<T> ** slabs;    // every slab we have allocated
+   int numSlabs;        // how many slabs are in use
+   int slabCap;         // how many slab pointers fit in slabs
+   int used;            // Nodes handed out from the newest slab
+   int slabSize;        // Nodes in the newest slab
+   Node<T> * freeList;  // Nodes given back, ready for reuse
+   Node<T> * freeTail;  // last Node on freeList, so adopt() is O(1)
+
+   // default constructor : nothing allocated until the first Node
+   NodePool() : slabs(NULL), numSlabs(0), slabCap(0), used(0),
+                slabSize(0), freeList(NULL), freeTail(NULL) {}
+
+   // destructor : free every slab
+   ~NodePool()          { clear(); delete [] slabs; }
+
+   // get a Node holding nData
+   Node<T> * alloc(const T & nData) throw (const char *);
+
+   // give a Node back for reuse
+   void free(Node<T> * node);
+
+   // give back every Node at once
+   void clear();
+
+   // take over every slab of rhs, so Nodes handed out by rhs now
+   // belong to us.  Used when one List's Nodes are spliced into another.
+   void adopt(NodePool<T> & rhs);
+
+private:
+   // start a new slab, each one twice the last up to a limit
+   void newSlab();
+
+   // no copying, the Nodes belong to whoever we handed them to
+   NodePool(const NodePool & rhs);
+   NodePool & operator = (const NodePool & rhs);
+};
+
+/***************************************************
+ * NodePool :: newSlab
+ **************************************************/
+template <class T>
+void NodePool <T> :: newSlab()
+{
+   if (numSlabs == slabCap)
+   {
+      // double the list of slabs
+      int nCap = slabCap ? slabCap * 2 : 8;
+      Node<T> ** nSlabs = new Node<T> * [nCap];
+      for (int i = 0; i < numSlabs; i++)
+         nSlabs[i] = slabs[i];
+      delete [] slabs;
+      slabs = nSlabs;
+      slabCap = nCap;
+   }
+
+   slabSize = slabSize == 0 ? 16 : (slabSize < 4096 ? slabSize * 2 : slabSize);
+   slabs[numSlabs++] = new Node<T>[slabSize];
+   used = 0;
+}
+
+/***************************************************
+ * NodePool :: alloc
+ * Reuse a freed Node if there is one, otherwise
+ * take the next Node of the newest slab.
+ **************************************************/
+template <class T>
+Node <T> * NodePool <T> :: alloc(const T & nData) throw (const char *)
+{
+   Node<T> * node;
+
+   if (freeList)
+   {
+      node = freeList;
+      freeList = freeList->pNext;
+      if (freeList == NULL)
+         freeTail = NULL;
+   }
+   else
+   {
+      try
+      {
+         if (numSlabs == 0 || used == slabSize)
+            newSlab();
+      }
+      catch (std::bad_alloc)
+      {
+         throw "ERROR: Unable to allocate a node";
+      }
+      node = &slabs[numSlabs - 1][used++];
+   }
+
+   node->data = nData;
+   node->pNext = NULL;
+   node->pPrev = NULL;
+   return node;
+}
+
+/***************************************************
+ * NodePool :: free
+ **************************************************/
+template <class T>
+void NodePool <T> :: free(Node<T> * node)
+{
+   node->pNext = freeList;
+   freeList = node;
+   if (freeTail == NULL)
+      freeTail = node;
+}
+
+/***************************************************
+ * NodePool :: clear
+ * O(slabs), not O(Nodes).
+ **************************************************/
+template <class T>
+void NodePool <T> :: clear()
+{
+   for (int i = 0; i < numSlabs; i++)
+      delete [] slabs[i];
+
+   numSlabs = used = slabSize = 0;
+   freeList = freeTail = NULL;
+}
+
+/***************************************************
+ * NodePool :: adopt
+ * rhs's slabs go in front of our newest slab so we
+ * keep handing out Nodes from where we left off.
+ * The unused end of rhs's newest slab just waits
+ * for clear().
+ **************************************************/
+template <class T>
+void NodePool <T> :: adopt(NodePool<T> & rhs)
+{
+   if (this == &rhs || rhs.numSlabs == 0)
+      return;
+
+   // make room for their slab pointers
+   if (numSlabs + rhs.numSlabs > slabCap)
+   {
+      int nCap = slabCap;
+      while (numSlabs + rhs.numSlabs > nCap)
+         nCap = nCap ? nCap * 2 : 8;
+      Node<T> ** nSlabs = new Node<T> * [nCap];
+      for (int i = 0; i < numSlabs; i++)
+         nSlabs[i] = slabs[i];
+      delete [] slabs;
+      slabs = nSlabs;
+      slabCap = nCap;
+   }
+
+   if (numSlabs == 0)
+   {
+      // nothing of our own, carry on from their newest slab
+      for (int i = 0; i < rhs.numSlabs; i++)
+         slabs[i] = rhs.slabs[i];
+      used = rhs.used;
+      slabSize = rhs.slabSize;
+   }
+   else
+   {
+      Node<T> * newest = slabs[numSlabs - 1];
+      for (int i = 0; i < rhs.numSlabs; i++)
+         slabs[numSlabs - 1 + i] = rhs.slabs[i];
+      slabs[numSlabs - 1 + rhs.numSlabs] = newest;
+   }
+   numSlabs += rhs.numSlabs;
+
+   // their free Nodes are ours now too
+   if (rhs.freeList)
+   {
+      rhs.freeTail->pNext = freeList;
+      if (freeList == NULL)
+         freeTail = rhs.freeTail;
+      freeList = rhs.freeList;
+   }
+
+   rhs.numSlabs = rhs.used = rhs.slabSize = 0;
+   rhs.freeList = rhs.freeTail = NULL;
+}
+
 /***************************************************
  * Node :: copy
  * Receives a node, copys it, and returns the copy
@@ -75,6 +268,28 @@ void insert(T nData, Node<T> *&prev, bool head = false)
    }
 }
 
+/***************************************************
+ * Node :: INSERT
+ * Same as above, but the new node comes from pool
+ **************************************************/
+template <class T>
+void insert(T nData, Node<T> *&prev, NodePool<T> & pool, bool head = false)
+{
+	// this is the node that will be inserted
+   Node <T>* nNode = pool.alloc(nData);
+
+   if (head || prev == NULL)
+   {
+   	nNode->pNext = prev;
+   	prev = nNode;
+   }
+   else
+   {
+   	nNode->pNext = prev->pNext;
+   	prev->pNext = nNode;
+   }
+}
+
 /***************************************************
  * Node :: find
  * Takes a template parameter and returns an node
@@ -97,23 +312,35 @@ Node <T> * find(Node<T>* head, const T & get)
 
 /***************************************************
  * Node :: freeData
- * Takes a Node parameter and will recursively free
- * up all the space in the linked list.
+ * Takes a Node parameter and will free up all the
+ * space in the linked list.  This walks the list
+ * instead of recursing so a long list can't blow
+ * the stack.
  **************************************************/
 template <class T>
 void freeData(Node<T> *&n)
 {
-	if (n != NULL) // if there's data, delete
+	while (n != NULL) // if there's data, delete
 	{
-		freeData(n->pNext);
+		Node<T> *next = n->pNext;
 		delete n;
-		n = NULL;
+		n = next;
 	}
-	else
+}
+
+/***************************************************
+ * Node :: freeData
+ * Same as above, but gives the nodes back to pool
+ **************************************************/
+template <class T>
+void freeData(Node<T> *&n, NodePool<T> & pool)
+{
+	while (n != NULL)
 	{
-		return; // anchor
+		Node<T> *next = n->pNext;
+		pool.free(n);
+		n = next;
 	}
-
 }
 
 /******************************************
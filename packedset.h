@@ -0,0 +1,502 @@
+/***************************************************************
+ * File: packedset.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the PackedSet class.  An
+ *    ordered set in a packed memory array: a sorted array with the
+ * free space spread through it, so an insert or erase only shifts a
+ * few neighbors instead of half the Set.
+ *
+ *    The array is cut into segments of segSize slots.  Each segment
+ * keeps its items packed at its front, so a scan is a run of
+ * contiguous loops.  Segments pair up into windows of 2, 4, 8, ...
+ * segments, up to the whole array.  Each level of window has a
+ * density range, tight at the top and loose at the leaves:
+ *
+ *    upper:  1.0 for a segment   down to 0.7 for the whole array
+ *    lower:  0.125 for a segment up to   0.3 for the whole array
+ *
+ * When a change pushes a segment out of its range we find the
+ * smallest window around it that is in range and spread its items
+ * evenly across it.  If even the whole array is out of range it
+ * doubles or halves.  That gives O(log^2 n) amortized moves per
+ * insert or erase.
+ ***************************************************************/
+#ifndef PACKEDSET_H
+#define PACKEDSET_H
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// smallest segment, and smallest array (one segment)
+#define PACKED_MIN_SEGMENT 16
+
+// forward declaration for PackedSetIterator
+template <class T>
+class PackedSetIterator;
+
+/************************************************
+ * PackedSet
+ * A Set that stays fast to change when it is big.
+ ***********************************************/
+template <class T>
+class PackedSet
+{
+public:
+   // Default constructor : one empty segment
+   PackedSet() throw (const char *);
+
+   // Copy constructor
+   PackedSet(const PackedSet & rhs) throw (const char *);
+
+   // Destructor
+   ~PackedSet()         { delete [] data; delete [] counts; }
+
+   // Assignment operator
+   PackedSet & operator = (const PackedSet & rhs) throw (const char *);
+
+   bool empty() const   { return numItems == 0; }
+   int size() const     { return numItems;      }
+   int capacity() const { return cap;           }
+
+   // drop everything and shrink back to one segment
+   void clear() throw (const char *);
+
+   // add t, false if it was already there
+   bool insert(const T & t) throw (const char *);
+
+   // remove t, false if it wasn't there
+   bool erase(const T & t) throw (const char *);
+
+   bool contains(const T & t) const;
+
+   // the item equal to t, or end()
+   PackedSetIterator <T> find(const T & t) const;
+
+   // the first item not less than t, or end()
+   PackedSetIterator <T> lower_bound(const T & t) const;
+
+   PackedSetIterator <T> begin() const;
+   PackedSetIterator <T> end() const;
+
+private:
+   friend class PackedSetIterator <T>;
+
+   // the segment t belongs in: the last one whose first item is
+   // not more than t, or 0
+   int segmentFor(const T & t) const;
+
+   // where t is or would go within segment seg
+   int slotFor(int seg, const T & t) const
+   {
+      const T * first = data + seg * segSize;
+      return (int)(std::lower_bound(first, first + counts[seg], t) - first);
+   }
+
+   // density range of a window at level (0 is one segment)
+   double upper(int level) const;
+   double lower(int level) const;
+
+   // spread the items of segments [lo, hi) evenly across them
+   void spread(int lo, int hi, vector<T> & items);
+   void rebalance(int lo, int hi);
+
+   // move everything into newCap slots
+   void resize(int newCap) throw (const char *);
+
+   T * data;         // cap slots
+   int * counts;     // items at the front of each segment
+   int cap;          // numSegments * segSize, a power of two
+   int segSize;      // a power of two
+   int numSegments;  // a power of two
+   int height;       // log2(numSegments)
+   int numItems;
+};
+
+/**************************************************
+ * PackedSet ITERATOR
+ * Steps through a segment's items, then on to
+ * the next segment.
+ *************************************************/
+template <class T>
+class PackedSetIterator
+{
+public:
+   PackedSetIterator() : set(NULL), seg(0), i(0) {}
+   PackedSetIterator(const PackedSet <T> * set, int seg, int i) : set(set), seg(seg), i(i)
+   {
+      skip();
+   }
+
+   bool operator != (const PackedSetIterator & rhs) const { return seg != rhs.seg || i != rhs.i; }
+   bool operator == (const PackedSetIterator & rhs) const { return seg == rhs.seg && i == rhs.i; }
+
+   // dereference operator
+   const T & operator * () const { return set->data[seg * set->segSize + i]; }
+
+   // prefix increment
+   PackedSetIterator & operator ++ ()
+   {
+      i++;
+      skip();
+      return *this;
+   }
+
+   // postfix increment
+   PackedSetIterator operator ++ (int)
+   {
+      PackedSetIterator tmp(*this);
+      ++(*this);
+      return tmp;
+   }
+
+private:
+   // past the end of a segment is the start of the next
+   void skip()
+   {
+      while (seg < set->numSegments && i >= set->counts[seg])
+      {
+         seg++;
+         i = 0;
+      }
+   }
+
+   const PackedSet <T> * set;
+   int seg;
+   int i;
+};
+
+/*******************************************
+ * PackedSet :: DEFAULT CONSTRUCTOR
+ *******************************************/
+template <class T>
+PackedSet <T> :: PackedSet() throw (const char *)
+   : data(NULL), counts(NULL), cap(0), segSize(0), numSegments(0),
+     height(0), numItems(0)
+{
+   resize(PACKED_MIN_SEGMENT);
+}
+
+/*******************************************
+ * PackedSet :: COPY CONSTRUCTOR
+ *******************************************/
+template <class T>
+PackedSet <T> :: PackedSet(const PackedSet <T> & rhs) throw (const char *)
+   : data(NULL), counts(NULL), cap(0), segSize(0), numSegments(0),
+     height(0), numItems(0)
+{
+   *this = rhs;
+}
+
+/*******************************************
+ * PackedSet :: ASSIGNMENT OPERATOR
+ *******************************************/
+template <class T>
+PackedSet <T> & PackedSet <T> :: operator = (const PackedSet <T> & rhs)
+   throw (const char *)
+{
+   if (this == &rhs)
+      return *this;
+
+   T * nData;
+   int * nCounts;
+   try
+   {
+      nData = new T[rhs.cap];
+      nCounts = new int[rhs.numSegments];
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate buffer";
+   }
+
+   for (int s = 0; s < rhs.numSegments; s++)
+   {
+      nCounts[s] = rhs.counts[s];
+      for (int i = 0; i < rhs.counts[s]; i++)
+         nData[s * rhs.segSize + i] = rhs.data[s * rhs.segSize + i];
+   }
+
+   delete [] data;
+   delete [] counts;
+   data = nData;
+   counts = nCounts;
+   cap = rhs.cap;
+   segSize = rhs.segSize;
+   numSegments = rhs.numSegments;
+   height = rhs.height;
+   numItems = rhs.numItems;
+   return *this;
+}
+
+/*******************************************
+ * PackedSet :: clear
+ *******************************************/
+template <class T>
+void PackedSet <T> :: clear() throw (const char *)
+{
+   numItems = 0;
+   for (int s = 0; s < numSegments; s++)
+      counts[s] = 0;
+   resize(PACKED_MIN_SEGMENT);
+}
+
+/*******************************************
+ * PackedSet :: upper, lower
+ * Straight lines from the leaf thresholds
+ * to the root thresholds.
+ *******************************************/
+template <class T>
+double PackedSet <T> :: upper(int level) const
+{
+   if (height == 0)
+      return 0.7;
+   return 1.0 - 0.3 * level / height;
+}
+
+template <class T>
+double PackedSet <T> :: lower(int level) const
+{
+   if (height == 0)
+      return 0.0;
+   return 0.125 + (0.3 - 0.125) * level / height;
+}
+
+/*******************************************
+ * PackedSet :: segmentFor
+ * Every segment has an item once there is
+ * more than one of them (the lower density
+ * bounds see to that), so this is a plain
+ * binary search on first items.
+ *******************************************/
+template <class T>
+int PackedSet <T> :: segmentFor(const T & t) const
+{
+   int lo = 0;
+   int hi = numSegments;
+   while (hi - lo > 1)
+   {
+      int mid = (lo + hi) / 2;
+      if (t < data[mid * segSize])
+         hi = mid;
+      else
+         lo = mid;
+   }
+   return lo;
+}
+
+/*******************************************
+ * PackedSet :: contains, find, lower_bound
+ *******************************************/
+template <class T>
+bool PackedSet <T> :: contains(const T & t) const
+{
+   int seg = segmentFor(t);
+   int i = slotFor(seg, t);
+   return i < counts[seg] && !(t < data[seg * segSize + i]);
+}
+
+template <class T>
+PackedSetIterator <T> PackedSet <T> :: find(const T & t) const
+{
+   int seg = segmentFor(t);
+   int i = slotFor(seg, t);
+   if (i < counts[seg] && !(t < data[seg * segSize + i]))
+      return PackedSetIterator <T> (this, seg, i);
+   return end();
+}
+
+template <class T>
+PackedSetIterator <T> PackedSet <T> :: lower_bound(const T & t) const
+{
+   int seg = segmentFor(t);
+   return PackedSetIterator <T> (this, seg, slotFor(seg, t));
+}
+
+template <class T>
+PackedSetIterator <T> PackedSet <T> :: begin() const
+{
+   return PackedSetIterator <T> (this, 0, 0);
+}
+
+template <class T>
+PackedSetIterator <T> PackedSet <T> :: end() const
+{
+   return PackedSetIterator <T> (this, numSegments, 0);
+}
+
+/*******************************************
+ * PackedSet :: insert
+ * If t's segment is full, rebalance larger
+ * and larger windows around it until one
+ * has room for t and the segment isn't full.
+ *******************************************/
+template <class T>
+bool PackedSet <T> :: insert(const T & t) throw (const char *)
+{
+   int seg = segmentFor(t);
+   int i = slotFor(seg, t);
+   if (i < counts[seg] && !(t < data[seg * segSize + i]))
+      return false;
+
+   for (int level = 0; counts[seg] == segSize; level++)
+   {
+      if (level > height)
+         resize(cap * 2);
+      else
+      {
+         int lo = seg & ~((1 << level) - 1);
+         int hi = lo + (1 << level);
+         int num = 0;
+         for (int s = lo; s < hi; s++)
+            num += counts[s];
+         if (num + 1 > upper(level) * (hi - lo) * segSize)
+            continue;
+         rebalance(lo, hi);
+      }
+      seg = segmentFor(t);
+   }
+
+   // shift the rest of the segment over one
+   i = slotFor(seg, t);
+   T * first = data + seg * segSize;
+   std::move_backward(first + i, first + counts[seg], first + counts[seg] + 1);
+   first[i] = t;
+   counts[seg]++;
+   numItems++;
+
+   // growing the whole array is checked on every insert so the
+   // segments never get close to full all at once
+   if (numItems > upper(height) * cap)
+      resize(cap * 2);
+   return true;
+}
+
+/*******************************************
+ * PackedSet :: erase
+ * If t's segment gets too sparse, rebalance
+ * the smallest window around it that is
+ * dense enough, or shrink the whole array.
+ *******************************************/
+template <class T>
+bool PackedSet <T> :: erase(const T & t) throw (const char *)
+{
+   int seg = segmentFor(t);
+   int i = slotFor(seg, t);
+   if (i == counts[seg] || t < data[seg * segSize + i])
+      return false;
+
+   T * first = data + seg * segSize;
+   std::move(first + i + 1, first + counts[seg], first + i);
+   counts[seg]--;
+   numItems--;
+
+   if (height == 0 || (counts[seg] > 0 && counts[seg] >= lower(0) * segSize))
+      return true;
+
+   for (int level = 1; level <= height; level++)
+   {
+      int lo = seg & ~((1 << level) - 1);
+      int hi = lo + (1 << level);
+      int num = 0;
+      for (int s = lo; s < hi; s++)
+         num += counts[s];
+      if (num >= lower(level) * (hi - lo) * segSize)
+      {
+         rebalance(lo, hi);
+         return true;
+      }
+   }
+
+   resize(cap / 2);
+   return true;
+}
+
+/*******************************************
+ * PackedSet :: spread
+ * The first numItems % segments segments get
+ * one extra.
+ *******************************************/
+template <class T>
+void PackedSet <T> :: spread(int lo, int hi, vector<T> & items)
+{
+   int segs = hi - lo;
+   int each = (int)items.size() / segs;
+   int extra = (int)items.size() % segs;
+   int k = 0;
+   for (int s = lo; s < hi; s++)
+   {
+      counts[s] = each + (s - lo < extra ? 1 : 0);
+      for (int i = 0; i < counts[s]; i++)
+         data[s * segSize + i] = std::move(items[k++]);
+   }
+}
+
+/*******************************************
+ * PackedSet :: rebalance
+ *******************************************/
+template <class T>
+void PackedSet <T> :: rebalance(int lo, int hi)
+{
+   vector<T> items;
+   for (int s = lo; s < hi; s++)
+      for (int i = 0; i < counts[s]; i++)
+         items.push_back(std::move(data[s * segSize + i]));
+   spread(lo, hi, items);
+}
+
+/*******************************************
+ * PackedSet :: resize
+ * Segments are about log2(cap) slots, so a
+ * segment scan costs about what the binary
+ * search to find it did.
+ *******************************************/
+template <class T>
+void PackedSet <T> :: resize(int newCap) throw (const char *)
+{
+   if (newCap < PACKED_MIN_SEGMENT)
+      newCap = PACKED_MIN_SEGMENT;
+
+   int log = 0;
+   while ((1 << log) < newCap)
+      log++;
+   int nSegSize = PACKED_MIN_SEGMENT;
+   while (nSegSize < log)
+      nSegSize *= 2;
+   int nSegments = newCap / nSegSize;
+
+   vector<T> items;
+   T * nData;
+   int * nCounts;
+   try
+   {
+      items.reserve(numItems);
+      nData = new T[newCap];
+      nCounts = new int[nSegments];
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate buffer";
+   }
+
+   for (int s = 0; s < numSegments; s++)
+      for (int i = 0; i < counts[s]; i++)
+         items.push_back(std::move(data[s * segSize + i]));
+
+   delete [] data;
+   delete [] counts;
+   data = nData;
+   counts = nCounts;
+   cap = newCap;
+   segSize = nSegSize;
+   numSegments = nSegments;
+   for (height = 0; (1 << height) < numSegments; height++)
+      ;
+
+   spread(0, numSegments, items);
+}
+
+#endif // PACKEDSET_H
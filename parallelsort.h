@@ -0,0 +1,103 @@
+/***********************************************************************
+* Program:
+*    Parallel Sort
+*
+* Author:
+*   Ryan Walker
+* Summary:
+*	 A merge sort that runs on the shared ThreadPool.  The array is cut
+* into one chunk per worker (rounded up to a power of two), every chunk
+* is sorted on its own, and then neighboring runs are merged pairwise,
+* all the merges of one round running at the same time.  Small arrays
+* are not worth the trouble and just use std::sort.
+************************************************************************/
+#ifndef PARALLELSORT_H
+#define PARALLELSORT_H
+
+#include "threadpool.h"
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+/*************************************************************************
+* parallelSort
+* This function sorts [first, last) with comp using the pool, or the
+* shared pool if none is given.  Small arrays never touch a pool, so
+* they never start the shared one.
+* Input:  first, last -  array to be sorted.
+* Output: first, last -  array sorted
+**************************************************************************/
+template <class T, class Compare>
+void parallelSort(T * first, T * last, Compare comp,
+                  ThreadPool * usePool = NULL)
+{
+	int num = (int)(last - first);
+	if (num < 32768)
+	{
+		std::sort(first, last, comp);
+		return;
+	}
+
+	ThreadPool & pool = usePool ? *usePool : ThreadPool::shared();
+	if (pool.size() < 2)
+	{
+		std::sort(first, last, comp);
+		return;
+	}
+
+	// one chunk per worker, a power of two so the merges pair up
+	int chunks = 1;
+	while (chunks < pool.size())
+		chunks *= 2;
+	int width = (num + chunks - 1) / chunks;
+
+	pool.parallel_for(0, chunks, 1, [=](int lo, int hi)
+	{
+		for (int c = lo; c < hi; c++)
+		{
+			int begin = min(num, c * width);
+			int end = min(num, begin + width);
+			std::sort(first + begin, first + end, comp);
+		}
+	});
+
+	// merge runs of width into runs of 2 * width, bouncing between
+	// the array and a buffer
+	vector<T> buffer(num);
+	T * from = first;
+	T * to = &buffer[0];
+	for (; width < num; width *= 2)
+	{
+		int pairs = (num + 2 * width - 1) / (2 * width);
+		pool.parallel_for(0, pairs, 1, [=](int lo, int hi)
+		{
+			for (int p = lo; p < hi; p++)
+			{
+				int begin = p * 2 * width;
+				int mid = min(num, begin + width);
+				int end = min(num, begin + 2 * width);
+				std::merge(from + begin, from + mid, from + mid, from + end,
+				           to + begin, comp);
+			}
+		});
+		std::swap(from, to);
+	}
+
+	// the last round may have left it in the buffer
+	if (from != first)
+		std::copy(from, from + num, first);
+}
+
+/*************************************************************************
+* parallelSort
+* Same as above, using operator<.
+**************************************************************************/
+template <class T>
+void parallelSort(T * first, T * last)
+{
+	parallelSort(first, last, less<T>());
+}
+
+#endif // PARALLELSORT_H
@@ -0,0 +1,544 @@
+/***********************************************************************
+ * Component:
+ *    Pooled Binary Search Tree
+ * Author:
+ *    Ryan Walker
+ * Summary:
+ *    The same red-black tree as BST, but the nodes live in one
+ * growable array and point at each other with 32-bit indices
+ * instead of 64-bit pointers.  A BST <int> node is 32 bytes plus
+ * the allocator's overhead; a PooledBST <int> node is 16 bytes and
+ * sits next to its neighbors.  Removed nodes go on a free list and
+ * are reused by the next inserts.  compact() renumbers the nodes
+ * in depth-first order, so a search walks mostly forward through
+ * memory and the free list's holes are squeezed out.
+ *
+ *    Slot 0 is the nil node.  Every missing child is 0, and the
+ * root's parent is 0.  Like the red-black trees in CLRS, the fixups
+ * may set nil's parent for a moment.
+ ************************************************************************/
+
+#ifndef POOLEDBST_H
+#define POOLEDBST_H
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// the red bit in PooledNode::parentAndColor
+#define POOLED_RED 0x80000000u
+
+/*****************************************************************
+ * POOLED NODE
+ * One slot in the pool.  The color rides in the top bit of the
+ * parent index, so a tree can hold up to 2^31 nodes.  A free
+ * slot's left is the next free slot.
+ *****************************************************************/
+template <class T>
+struct PooledNode
+{
+   T data;
+   unsigned int left;
+   unsigned int right;
+   unsigned int parentAndColor;
+
+   unsigned int parent() const   { return parentAndColor & ~POOLED_RED;  }
+   void setParent(unsigned int p) { parentAndColor = p | (parentAndColor & POOLED_RED); }
+   bool isRed() const            { return (parentAndColor & POOLED_RED) != 0; }
+   void setRed(bool red)         { parentAndColor = parent() | (red ? POOLED_RED : 0); }
+};
+
+// forward declaration for the iterator
+template <class T, bool Reverse = false>
+class PooledBSTIterator;
+
+/*****************************************************************
+ * POOLED BINARY SEARCH TREE
+ *****************************************************************/
+template <class T>
+class PooledBST
+{
+public:
+   typedef PooledBSTIterator <T>        iterator;
+   typedef PooledBSTIterator <T, true>  reverse_iterator;
+
+   // constructor : just the nil node
+   PooledBST() : root(0), freeList(0), numItems(0) { nodes.resize(1); nodes[0].left = nodes[0].right = nodes[0].parentAndColor = 0; }
+
+   // copying the array copies the tree, so the defaults will do
+
+   // how many items
+   int  size()  const { return numItems;      }
+   bool empty() const { return numItems == 0; }
+
+   // how many slots, used or free
+   int  capacity() const { return (int)nodes.size() - 1; }
+
+   // room for n items without growing the array
+   void reserve(int n)   { nodes.reserve(n + 1); }
+
+   // remove everything
+   void clear()       { nodes.resize(1); root = freeList = 0; numItems = 0; }
+
+   // insert an item
+   void insert(const T & t) throw (const char *);
+
+   // remove the item it points to
+   void remove(const iterator & it);
+
+   // find a given item
+   iterator find(const T & t) const;
+
+   // renumber the nodes in depth-first order and drop the free slots
+   void compact() throw (const char *);
+
+   // the usual iterator stuff
+   iterator begin() const          { return iterator(&nodes, extreme(root, true));  }
+   iterator end() const            { return iterator(&nodes, 0);                    }
+   reverse_iterator rbegin() const { return reverse_iterator(&nodes, extreme(root, false)); }
+   reverse_iterator rend() const   { return reverse_iterator(&nodes, 0);            }
+
+private:
+   // the slot for a new node, from the free list if there is one
+   unsigned int allocate(const T & t) throw (const char *);
+
+   // the leftmost (or rightmost) node under i
+   unsigned int extreme(unsigned int i, bool left) const;
+
+   // red-black upkeep, the same as BST's
+   void rotateLeft(unsigned int x);
+   void rotateRight(unsigned int x);
+   void insertFixup(unsigned int z);
+   void removeFixup(unsigned int x);
+   void transplant(unsigned int u, unsigned int v);
+
+   vector< PooledNode <T> > nodes;   // nodes[0] is nil
+   unsigned int root;
+   unsigned int freeList;            // first free slot, 0 if none
+   int numItems;
+};
+
+/**********************************************************
+ * POOLED BST ITERATOR
+ * An index into the pool.  The items are read-only, since
+ * changing one could put it out of order.
+ *********************************************************/
+template <class T, bool Reverse>
+class PooledBSTIterator
+{
+public:
+   PooledBSTIterator() : nodes(NULL), i(0) {}
+   PooledBSTIterator(const vector< PooledNode <T> > * nodes, unsigned int i)
+      : nodes(nodes), i(i) {}
+
+   bool operator == (const PooledBSTIterator & rhs) const { return i == rhs.i; }
+   bool operator != (const PooledBSTIterator & rhs) const { return i != rhs.i; }
+
+   const T & operator * () const  { return (*nodes)[i].data; }
+
+   PooledBSTIterator & operator ++ ()
+   {
+      if (i)
+         i = step(!Reverse);
+      return *this;
+   }
+   PooledBSTIterator   operator ++ (int postfix)
+   {
+      PooledBSTIterator itReturn = *this;
+      ++(*this);
+      return itReturn;
+   }
+   PooledBSTIterator & operator -- ()
+   {
+      if (i)
+         i = step(Reverse);
+      return *this;
+   }
+   PooledBSTIterator   operator -- (int postfix)
+   {
+      PooledBSTIterator itReturn = *this;
+      --(*this);
+      return itReturn;
+   }
+
+   // which slot, for PooledBST::remove
+   unsigned int index() const { return i; }
+
+private:
+   // same walk as bstStep in bst.h
+   unsigned int step(bool forward) const
+   {
+      const vector< PooledNode <T> > & n = *nodes;
+      unsigned int down = forward ? n[i].right : n[i].left;
+      if (down)
+      {
+         unsigned int next;
+         while ((next = forward ? n[down].left : n[down].right) != 0)
+            down = next;
+         return down;
+      }
+
+      unsigned int node = i;
+      unsigned int parent = n[node].parent();
+      while (parent && node == (forward ? n[parent].right : n[parent].left))
+      {
+         node = parent;
+         parent = n[parent].parent();
+      }
+      return parent;
+   }
+
+   const vector< PooledNode <T> > * nodes;
+   unsigned int i;
+};
+
+/*****************************************************
+ * POOLED BST :: ALLOCATE
+ * t may live in the pool itself (insert(*begin())),
+ * so it is copied out before the array can move.
+ ****************************************************/
+template <class T>
+unsigned int PooledBST <T> :: allocate(const T & t) throw (const char *)
+{
+   PooledNode <T> fresh;
+   fresh.data = t;
+   fresh.left = fresh.right = 0;
+   fresh.parentAndColor = POOLED_RED;   // new nodes are red
+
+   unsigned int i = freeList;
+   if (i)
+   {
+      freeList = nodes[i].left;
+      nodes[i] = fresh;
+      return i;
+   }
+
+   if (nodes.size() > POOLED_RED - 1)
+      throw "ERROR: PooledBST is full";
+   try
+   {
+      nodes.push_back(fresh);
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate a node";
+   }
+   return (unsigned int)nodes.size() - 1;
+}
+
+/*****************************************************
+ * POOLED BST :: EXTREME
+ ****************************************************/
+template <class T>
+unsigned int PooledBST <T> :: extreme(unsigned int i, bool left) const
+{
+   if (i == 0)
+      return 0;
+   unsigned int next;
+   while ((next = left ? nodes[i].left : nodes[i].right) != 0)
+      i = next;
+   return i;
+}
+
+/*****************************************************
+ * POOLED BST :: INSERT
+ * Equal items go to the left, as in BST.
+ ****************************************************/
+template <class T>
+void PooledBST <T> :: insert(const T & t) throw (const char *)
+{
+   unsigned int z = allocate(t);   // may move the array, so first
+   const T & item = nodes[z].data; // t may have moved with it
+
+   unsigned int parent = 0;
+   unsigned int ptr = root;
+   while (ptr)
+   {
+      parent = ptr;
+      ptr = (item <= nodes[ptr].data) ? nodes[ptr].left : nodes[ptr].right;
+   }
+
+   nodes[z].setParent(parent);
+   if (parent == 0)
+      root = z;
+   else if (item <= nodes[parent].data)
+      nodes[parent].left = z;
+   else
+      nodes[parent].right = z;
+
+   numItems++;
+   insertFixup(z);
+}
+
+/*****************************************************
+ * POOLED BST :: FIND
+ ****************************************************/
+template <class T>
+PooledBSTIterator <T> PooledBST <T> :: find(const T & t) const
+{
+   unsigned int ptr = root;
+   while (ptr)
+   {
+      if (t < nodes[ptr].data)
+         ptr = nodes[ptr].left;
+      else if (nodes[ptr].data < t)
+         ptr = nodes[ptr].right;
+      else
+         break;
+   }
+   return iterator(&nodes, ptr);
+}
+
+/*****************************************************
+ * POOLED BST :: TRANSPLANT
+ * Sets v's parent even when v is nil, which
+ * removeFixup counts on.
+ ****************************************************/
+template <class T>
+void PooledBST <T> :: transplant(unsigned int u, unsigned int v)
+{
+   unsigned int parent = nodes[u].parent();
+   if (parent == 0)
+      root = v;
+   else if (u == nodes[parent].left)
+      nodes[parent].left = v;
+   else
+      nodes[parent].right = v;
+   nodes[v].setParent(parent);
+}
+
+/*****************************************************
+ * POOLED BST :: ROTATE LEFT, ROTATE RIGHT
+ ****************************************************/
+template <class T>
+void PooledBST <T> :: rotateLeft(unsigned int x)
+{
+   unsigned int y = nodes[x].right;
+   nodes[x].right = nodes[y].left;
+   if (nodes[y].left)
+      nodes[nodes[y].left].setParent(x);
+   transplant(x, y);
+   nodes[y].left = x;
+   nodes[x].setParent(y);
+}
+
+template <class T>
+void PooledBST <T> :: rotateRight(unsigned int x)
+{
+   unsigned int y = nodes[x].left;
+   nodes[x].left = nodes[y].right;
+   if (nodes[y].right)
+      nodes[nodes[y].right].setParent(x);
+   transplant(x, y);
+   nodes[y].right = x;
+   nodes[x].setParent(y);
+}
+
+/*****************************************************
+ * POOLED BST :: INSERT FIXUP
+ ****************************************************/
+template <class T>
+void PooledBST <T> :: insertFixup(unsigned int z)
+{
+   while (nodes[nodes[z].parent()].isRed())
+   {
+      unsigned int parent = nodes[z].parent();
+      unsigned int grand = nodes[parent].parent();
+      bool leftSide = (parent == nodes[grand].left);
+      unsigned int uncle = leftSide ? nodes[grand].right : nodes[grand].left;
+
+      if (nodes[uncle].isRed())
+      {
+         nodes[parent].setRed(false);
+         nodes[uncle].setRed(false);
+         nodes[grand].setRed(true);
+         z = grand;
+         continue;
+      }
+
+      if (z == (leftSide ? nodes[parent].right : nodes[parent].left))
+      {
+         z = parent;
+         if (leftSide)
+            rotateLeft(z);
+         else
+            rotateRight(z);
+         parent = nodes[z].parent();
+      }
+      nodes[parent].setRed(false);
+      nodes[grand].setRed(true);
+      if (leftSide)
+         rotateRight(grand);
+      else
+         rotateLeft(grand);
+   }
+   nodes[root].setRed(false);
+}
+
+/*****************************************************
+ * POOLED BST :: REMOVE
+ * The freed slot goes on the free list.
+ ****************************************************/
+template <class T>
+void PooledBST <T> :: remove(const iterator & it)
+{
+   unsigned int z = it.index();
+   if (z == 0)
+      return;
+
+   unsigned int x;
+   bool removedBlack = !nodes[z].isRed();
+   if (nodes[z].left == 0)
+   {
+      x = nodes[z].right;
+      transplant(z, x);
+   }
+   else if (nodes[z].right == 0)
+   {
+      x = nodes[z].left;
+      transplant(z, x);
+   }
+   else
+   {
+      unsigned int y = extreme(nodes[z].right, true);
+      removedBlack = !nodes[y].isRed();
+      x = nodes[y].right;
+      if (nodes[y].parent() == z)
+         nodes[x].setParent(y);
+      else
+      {
+         transplant(y, x);
+         nodes[y].right = nodes[z].right;
+         nodes[nodes[y].right].setParent(y);
+      }
+      transplant(z, y);
+      nodes[y].left = nodes[z].left;
+      nodes[nodes[y].left].setParent(y);
+      nodes[y].setRed(nodes[z].isRed());
+   }
+
+   if (removedBlack)
+      removeFixup(x);
+   nodes[0].parentAndColor = 0;   // nil is black with no parent again
+
+   nodes[z].data = T();
+   nodes[z].left = freeList;
+   freeList = z;
+   numItems--;
+}
+
+/*****************************************************
+ * POOLED BST :: REMOVE FIXUP
+ ****************************************************/
+template <class T>
+void PooledBST <T> :: removeFixup(unsigned int x)
+{
+   while (x != root && !nodes[x].isRed())
+   {
+      unsigned int parent = nodes[x].parent();
+      bool leftSide = (x == nodes[parent].left);
+      unsigned int w = leftSide ? nodes[parent].right : nodes[parent].left;
+
+      if (nodes[w].isRed())
+      {
+         nodes[w].setRed(false);
+         nodes[parent].setRed(true);
+         if (leftSide)
+            rotateLeft(parent);
+         else
+            rotateRight(parent);
+         w = leftSide ? nodes[parent].right : nodes[parent].left;
+      }
+
+      unsigned int nearChild = leftSide ? nodes[w].left : nodes[w].right;
+      unsigned int farChild = leftSide ? nodes[w].right : nodes[w].left;
+      if (!nodes[nearChild].isRed() && !nodes[farChild].isRed())
+      {
+         nodes[w].setRed(true);
+         x = parent;
+         continue;
+      }
+
+      if (!nodes[farChild].isRed())
+      {
+         nodes[nearChild].setRed(false);
+         nodes[w].setRed(true);
+         if (leftSide)
+            rotateRight(w);
+         else
+            rotateLeft(w);
+         w = leftSide ? nodes[parent].right : nodes[parent].left;
+         farChild = leftSide ? nodes[w].right : nodes[w].left;
+      }
+
+      nodes[w].setRed(nodes[parent].isRed());
+      nodes[parent].setRed(false);
+      nodes[farChild].setRed(false);
+      if (leftSide)
+         rotateLeft(parent);
+      else
+         rotateRight(parent);
+      x = root;
+   }
+   nodes[x].setRed(false);
+}
+
+/*****************************************************
+ * POOLED BST :: COMPACT
+ * Preorder numbering puts each node right before its
+ * left subtree, so the first step of every search is
+ * usually in the same cache line.
+ ****************************************************/
+template <class T>
+void PooledBST <T> :: compact() throw (const char *)
+{
+   vector< PooledNode <T> > packed;
+   vector<unsigned int> renumber;
+   vector<unsigned int> todo;
+   try
+   {
+      packed.reserve(numItems + 1);
+      renumber.assign(nodes.size(), 0);
+
+      // the walk holds at most one node per level, and a red-black
+      // tree is at most 2 log2(n + 1) deep, so todo never grows
+      int depth = 2;
+      for (size_t n = numItems + 1; n > 1; n >>= 1)
+         depth += 2;
+      todo.reserve(depth);
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate buffer";
+   }
+
+   packed.push_back(nodes[0]);
+   if (root)
+      todo.push_back(root);
+   while (!todo.empty())
+   {
+      unsigned int i = todo.back();
+      todo.pop_back();
+      renumber[i] = (unsigned int)packed.size();
+      packed.push_back(nodes[i]);
+      if (nodes[i].right)
+         todo.push_back(nodes[i].right);
+      if (nodes[i].left)
+         todo.push_back(nodes[i].left);
+   }
+
+   for (size_t i = 1; i < packed.size(); i++)
+   {
+      packed[i].left = renumber[packed[i].left];
+      packed[i].right = renumber[packed[i].right];
+      packed[i].setParent(renumber[packed[i].parent()]);
+   }
+
+   nodes.swap(packed);
+   root = renumber[root];
+   freeList = 0;
+}
+
+#endif // POOLEDBST_H
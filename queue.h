@@ -30,7 +30,7 @@ public:
    int myBack;        // back item on the queue
 
    // default constructor : empty and kinda useless
-   Queue() : myFront(0), myBack(0), numItems(0), cap(0), data(NULL) {}
+   Queue() : data(NULL), numItems(0), cap(0), myFront(0), myBack(0) {}
 
    // copy constructor : copy it
    Queue(const Queue & rhs) throw (const char *);
@@ -0,0 +1,1030 @@
+/***************************************************************
+ * File: roaringset.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the RoaringSet class.  A
+ *    compressed set of 32-bit unsigned integers (a Roaring bitmap).
+ * Each value is split into its high and low 16 bits.  All values
+ * with the same high half share one container, which holds their
+ * low halves in whichever of three forms is smallest:
+ *
+ *    array   sorted 16-bit values, for up to 4096 of them
+ *    bitmap  65536 bits, for more than that
+ *    run     (start, length) pairs, for long stretches; only
+ *            made by runOptimize()
+ *
+ * so a set of n ids costs at most about 2 bytes each and often far
+ * less.  Set operations work a container at a time: arrays merge
+ * (see setops.h), bitmaps combine 64 bits per instruction, and the
+ * size comes from popcounts.
+ *
+ *    serialize() writes the portable Roaring format, the one the
+ * C, Java and Go Roaring libraries read and write.
+ *
+ *    int keys can be stored too; they are taken as unsigned, so
+ * negative numbers come after all the positive ones.
+ ***************************************************************/
+#ifndef ROARINGSET_H
+#define ROARINGSET_H
+
+#include "set.h"
+#include "setops.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// most values an array container holds before it becomes a bitmap
+#define ROARING_ARRAY_MAX 4096
+
+// 64-bit words in a bitmap container
+#define ROARING_WORDS 1024
+
+// the cookies that start a serialized RoaringSet
+#define ROARING_COOKIE        12347
+#define ROARING_COOKIE_NO_RUN 12346
+
+/************************************************
+ * RoaringContainer
+ * The low 16 bits of every value with one high
+ * 16 bits.  In a RoaringSet it is never empty.
+ ***********************************************/
+class RoaringContainer
+{
+public:
+   enum Type { ARRAY, BITMAP, RUN };
+
+   // which set operation combine() does
+   enum Op { AND, OR, ANDNOT, XOR };
+
+   Type type;
+   int card;                          // how many values
+   vector<unsigned short> values;     // ARRAY: the values.  RUN: start, length - 1 pairs
+   vector<unsigned long long> words;  // BITMAP: the bits
+
+   RoaringContainer() : type(ARRAY), card(0) {}
+
+   bool contains(unsigned short v) const;
+   bool insert(unsigned short v);
+   bool erase(unsigned short v);
+
+   // use a run container if that is smallest, else the usual form
+   void runOptimize();
+
+   // bytes this container takes serialized
+   int serializedSize() const;
+
+   // this op rhs
+   static RoaringContainer combine(const RoaringContainer & lhs,
+                                   const RoaringContainer & rhs, Op op);
+
+   // walking the values.  pos and sub mean different things
+   // for each type, but start(), done() and advance() know.
+   void start(int & pos, int & sub) const;
+   bool done(int pos, int sub) const;
+   void advance(int & pos, int & sub) const;
+   unsigned short value(int pos, int sub) const;
+
+private:
+   // convert to another type
+   void toArray();
+   void toBitmap();
+   void toRun();
+
+   // a run container back to array or bitmap, whichever fits
+   void unrun()      { if (card <= ROARING_ARRAY_MAX) toArray(); else toBitmap(); }
+
+   // array if it fits, else bitmap
+   void normalize();
+
+   // how many runs the values make
+   int countRuns() const;
+
+   // the bits of this container: words itself for a bitmap,
+   // else filled into scratch
+   const unsigned long long * bitmap(vector<unsigned long long> & scratch) const;
+
+   // first set bit at or after v, 65536 if none
+   int nextBit(int v) const;
+
+   static int popcount(unsigned long long w)   { return __builtin_popcountll(w); }
+   static int lowestBit(unsigned long long w)  { return __builtin_ctzll(w);      }
+};
+
+// forward declaration for RoaringSetIterator
+class RoaringSetIterator;
+
+/************************************************
+ * RoaringSet
+ * Containers are kept sorted by their high 16
+ * bits, so the set walks in order.
+ ***********************************************/
+class RoaringSet
+{
+public:
+   // Default constructor : empty
+   RoaringSet() {}
+
+   // Range constructor : any order, duplicates ok
+   template <class Iterator>
+   RoaringSet(Iterator first, Iterator last)
+   {
+      for (; first != last; ++first)
+         insert((unsigned int)*first);
+   }
+
+   // From a Set of int or unsigned, which is already in order
+   template <class T>
+   RoaringSet(const Set <T> & set)
+   {
+      for (int i = 0; i < set.numItems; i++)
+         insert((unsigned int)set.data[i]);
+   }
+
+   // how many values?  Can be more than an int holds.
+   long long size() const;
+   bool empty() const        { return keys.empty(); }
+   void clear()              { keys.clear(); containers.clear(); }
+
+   // add and remove, false if nothing changed
+   bool insert(unsigned int x);
+   bool erase(unsigned int x);
+
+   bool contains(unsigned int x) const;
+
+   // shrink containers with long stretches of values into runs
+   void runOptimize();
+
+   // Set algebra
+   RoaringSet intersect(const RoaringSet & rhs) const            { return combine(rhs, RoaringContainer::AND);    }
+   RoaringSet unite(const RoaringSet & rhs) const                { return combine(rhs, RoaringContainer::OR);     }
+   RoaringSet difference(const RoaringSet & rhs) const           { return combine(rhs, RoaringContainer::ANDNOT); }
+   RoaringSet symmetric_difference(const RoaringSet & rhs) const { return combine(rhs, RoaringContainer::XOR);    }
+
+   RoaringSet operator && (const RoaringSet & rhs) const   { return intersect(rhs);            }
+   RoaringSet operator || (const RoaringSet & rhs) const   { return unite(rhs);                }
+   RoaringSet operator -  (const RoaringSet & rhs) const   { return difference(rhs);           }
+   RoaringSet operator ^  (const RoaringSet & rhs) const   { return symmetric_difference(rhs); }
+
+   bool operator == (const RoaringSet & rhs) const;
+   bool operator != (const RoaringSet & rhs) const         { return !(*this == rhs); }
+
+   // the portable Roaring format
+   void serialize(ostream & out) const throw (const char *);
+   static RoaringSet deserialize(istream & in) throw (const char *);
+   long long serializedSize() const;
+
+   RoaringSetIterator begin() const;
+   RoaringSetIterator end() const;
+
+private:
+   friend class RoaringSetIterator;
+
+   // index of the container for high bits key, or where it would go
+   int locate(unsigned short key) const;
+
+   RoaringSet combine(const RoaringSet & rhs, RoaringContainer::Op op) const;
+
+   vector<unsigned short> keys;            // high 16 bits, ascending
+   vector<RoaringContainer> containers;    // containers[i] holds keys[i]
+};
+
+/**************************************************
+ * RoaringSet ITERATOR
+ * The values in ascending order.
+ *************************************************/
+class RoaringSetIterator
+{
+public:
+   RoaringSetIterator() : set(NULL), c(0), pos(0), sub(0) {}
+   RoaringSetIterator(const RoaringSet * set, int c) : set(set), c(c), pos(0), sub(0)
+   {
+      if (c < (int)set->containers.size())
+         set->containers[c].start(pos, sub);
+   }
+
+   bool operator == (const RoaringSetIterator & rhs) const
+   {
+      return c == rhs.c && pos == rhs.pos && sub == rhs.sub;
+   }
+   bool operator != (const RoaringSetIterator & rhs) const { return !(*this == rhs); }
+
+   // dereference operator
+   unsigned int operator * () const
+   {
+      return ((unsigned int)set->keys[c] << 16) | set->containers[c].value(pos, sub);
+   }
+
+   // prefix increment
+   RoaringSetIterator & operator ++ ()
+   {
+      const RoaringContainer & container = set->containers[c];
+      container.advance(pos, sub);
+      if (container.done(pos, sub))
+      {
+         pos = sub = 0;
+         if (++c < (int)set->containers.size())
+            set->containers[c].start(pos, sub);
+      }
+      return *this;
+   }
+
+   // postfix increment
+   RoaringSetIterator operator ++ (int)
+   {
+      RoaringSetIterator tmp(*this);
+      ++(*this);
+      return tmp;
+   }
+
+private:
+   const RoaringSet * set;
+   int c;      // which container
+   int pos;    // where in it
+   int sub;
+};
+
+inline RoaringSetIterator RoaringSet :: begin() const
+{
+   return RoaringSetIterator(this, 0);
+}
+
+inline RoaringSetIterator RoaringSet :: end() const
+{
+   return RoaringSetIterator(this, (int)containers.size());
+}
+
+/*******************************************
+ * RoaringContainer :: contains
+ *******************************************/
+inline bool RoaringContainer :: contains(unsigned short v) const
+{
+   switch (type)
+   {
+      case ARRAY:
+         return binary_search(values.begin(), values.end(), v);
+      case BITMAP:
+         return (words[v >> 6] >> (v & 63)) & 1;
+      case RUN:
+      {
+         // the last run that starts at or before v
+         int lo = 0;
+         int hi = (int)values.size() / 2;
+         while (lo < hi)
+         {
+            int mid = (lo + hi) / 2;
+            if (values[2 * mid] <= v)
+               lo = mid + 1;
+            else
+               hi = mid;
+         }
+         return lo > 0 && v - values[2 * (lo - 1)] <= values[2 * (lo - 1) + 1];
+      }
+   }
+   return false;
+}
+
+/*******************************************
+ * RoaringContainer :: insert
+ * A run container is unpacked first.  It
+ * can be packed again with runOptimize().
+ *******************************************/
+inline bool RoaringContainer :: insert(unsigned short v)
+{
+   if (type == RUN)
+      unrun();
+
+   if (type == ARRAY)
+   {
+      vector<unsigned short>::iterator it = lower_bound(values.begin(), values.end(), v);
+      if (it != values.end() && *it == v)
+         return false;
+      if (card < ROARING_ARRAY_MAX)
+      {
+         values.insert(it, v);
+         card++;
+         return true;
+      }
+      toBitmap();
+   }
+
+   unsigned long long bit = 1ULL << (v & 63);
+   if (words[v >> 6] & bit)
+      return false;
+   words[v >> 6] |= bit;
+   card++;
+   return true;
+}
+
+/*******************************************
+ * RoaringContainer :: erase
+ *******************************************/
+inline bool RoaringContainer :: erase(unsigned short v)
+{
+   if (type == RUN)
+   {
+      if (!contains(v))
+         return false;
+      unrun();
+   }
+
+   if (type == ARRAY)
+   {
+      vector<unsigned short>::iterator it = lower_bound(values.begin(), values.end(), v);
+      if (it == values.end() || *it != v)
+         return false;
+      values.erase(it);
+      card--;
+      return true;
+   }
+
+   unsigned long long bit = 1ULL << (v & 63);
+   if (!(words[v >> 6] & bit))
+      return false;
+   words[v >> 6] &= ~bit;
+   card--;
+   normalize();
+   return true;
+}
+
+/*******************************************
+ * RoaringContainer :: countRuns
+ * A run starts at every value whose value
+ * minus one is missing.  For a bitmap that
+ * is w & ~(w << 1) a word at a time, with
+ * the top bit of the word before carried in.
+ *******************************************/
+inline int RoaringContainer :: countRuns() const
+{
+   switch (type)
+   {
+      case ARRAY:
+      {
+         int runs = card ? 1 : 0;
+         for (int i = 1; i < card; i++)
+            if (values[i] != values[i - 1] + 1)
+               runs++;
+         return runs;
+      }
+      case BITMAP:
+      {
+         int runs = 0;
+         unsigned long long carry = 0;
+         for (int i = 0; i < ROARING_WORDS; i++)
+         {
+            runs += popcount(words[i] & ~((words[i] << 1) | carry));
+            carry = words[i] >> 63;
+         }
+         return runs;
+      }
+      case RUN:
+         return (int)values.size() / 2;
+   }
+   return 0;
+}
+
+/*******************************************
+ * RoaringContainer :: runOptimize
+ * Sizes are what each form serializes to.
+ *******************************************/
+inline void RoaringContainer :: runOptimize()
+{
+   int runBytes = 2 + 4 * countRuns();
+   int plainBytes = card <= ROARING_ARRAY_MAX ? 2 * card : 8 * ROARING_WORDS;
+   if (runBytes < plainBytes)
+   {
+      if (type != RUN)
+         toRun();
+   }
+   else if (type == RUN)
+      unrun();
+}
+
+/*******************************************
+ * RoaringContainer :: serializedSize
+ *******************************************/
+inline int RoaringContainer :: serializedSize() const
+{
+   switch (type)
+   {
+      case ARRAY:  return 2 * card;
+      case BITMAP: return 8 * ROARING_WORDS;
+      case RUN:    return 2 + 2 * (int)values.size();
+   }
+   return 0;
+}
+
+/*******************************************
+ * RoaringContainer :: bitmap
+ *******************************************/
+inline const unsigned long long *
+RoaringContainer :: bitmap(vector<unsigned long long> & scratch) const
+{
+   if (type == BITMAP)
+      return &words[0];
+
+   scratch.assign(ROARING_WORDS, 0);
+   if (type == ARRAY)
+   {
+      for (int i = 0; i < card; i++)
+         scratch[values[i] >> 6] |= 1ULL << (values[i] & 63);
+   }
+   else
+   {
+      for (size_t r = 0; r < values.size(); r += 2)
+      {
+         // set bits [lo, hi] a word at a time
+         int lo = values[r];
+         int hi = lo + values[r + 1];
+         for (int w = lo >> 6; w <= hi >> 6; w++)
+         {
+            unsigned long long mask = ~0ULL;
+            if (w == lo >> 6)
+               mask &= ~0ULL << (lo & 63);
+            if (w == hi >> 6)
+               mask &= ~0ULL >> (63 - (hi & 63));
+            scratch[w] |= mask;
+         }
+      }
+   }
+   return &scratch[0];
+}
+
+/*******************************************
+ * RoaringContainer :: toBitmap
+ *******************************************/
+inline void RoaringContainer :: toBitmap()
+{
+   vector<unsigned long long> bits;
+   bitmap(bits);
+   words.swap(bits);
+   values.clear();
+   values.shrink_to_fit();
+   type = BITMAP;
+}
+
+/*******************************************
+ * RoaringContainer :: toArray
+ *******************************************/
+inline void RoaringContainer :: toArray()
+{
+   assert(card <= ROARING_ARRAY_MAX);
+   vector<unsigned short> out;
+   out.reserve(card);
+   int pos, sub;
+   for (start(pos, sub); !done(pos, sub); advance(pos, sub))
+      out.push_back(value(pos, sub));
+
+   values.swap(out);
+   words.clear();
+   words.shrink_to_fit();
+   type = ARRAY;
+}
+
+/*******************************************
+ * RoaringContainer :: toRun
+ *******************************************/
+inline void RoaringContainer :: toRun()
+{
+   vector<unsigned short> runs;
+   runs.reserve(2 * countRuns());
+   int pos, sub;
+   for (start(pos, sub); !done(pos, sub); advance(pos, sub))
+   {
+      unsigned short v = value(pos, sub);
+      if (!runs.empty() && runs[runs.size() - 2] + runs.back() + 1 == v)
+         runs.back()++;
+      else
+      {
+         runs.push_back(v);
+         runs.push_back(0);
+      }
+   }
+
+   values.swap(runs);
+   words.clear();
+   words.shrink_to_fit();
+   type = RUN;
+}
+
+/*******************************************
+ * RoaringContainer :: normalize
+ *******************************************/
+inline void RoaringContainer :: normalize()
+{
+   if (type == BITMAP && card <= ROARING_ARRAY_MAX)
+      toArray();
+   else if (type == ARRAY && card > ROARING_ARRAY_MAX)
+      toBitmap();
+}
+
+/*******************************************
+ * RoaringContainer :: nextBit
+ *******************************************/
+inline int RoaringContainer :: nextBit(int v) const
+{
+   if (v >= 65536)
+      return 65536;
+   int w = v >> 6;
+   unsigned long long bits = words[w] & (~0ULL << (v & 63));
+   while (!bits)
+   {
+      if (++w == ROARING_WORDS)
+         return 65536;
+      bits = words[w];
+   }
+   return w * 64 + lowestBit(bits);
+}
+
+/*******************************************
+ * RoaringContainer :: start, done,
+ * advance, value
+ * ARRAY:  pos is the index
+ * BITMAP: pos is the value
+ * RUN:    pos is the run, sub how far in
+ *******************************************/
+inline void RoaringContainer :: start(int & pos, int & sub) const
+{
+   sub = 0;
+   pos = (type == BITMAP) ? nextBit(0) : 0;
+}
+
+inline bool RoaringContainer :: done(int pos, int) const
+{
+   switch (type)
+   {
+      case ARRAY:  return pos >= card;
+      case BITMAP: return pos >= 65536;
+      case RUN:    return pos >= (int)values.size() / 2;
+   }
+   return true;
+}
+
+inline void RoaringContainer :: advance(int & pos, int & sub) const
+{
+   switch (type)
+   {
+      case ARRAY:
+         pos++;
+         break;
+      case BITMAP:
+         pos = nextBit(pos + 1);
+         break;
+      case RUN:
+         if (sub < values[2 * pos + 1])
+            sub++;
+         else
+         {
+            pos++;
+            sub = 0;
+         }
+         break;
+   }
+}
+
+inline unsigned short RoaringContainer :: value(int pos, int sub) const
+{
+   switch (type)
+   {
+      case ARRAY:  return values[pos];
+      case BITMAP: return (unsigned short)pos;
+      case RUN:    return (unsigned short)(values[2 * pos] + sub);
+   }
+   return 0;
+}
+
+/*******************************************
+ * RoaringContainer :: combine
+ * Two arrays merge.  An array ANDed with
+ * anything (or an array minus anything) is
+ * filtered one value at a time.  Everything
+ * else is done on bitmaps, 64 values per
+ * instruction, counting as it goes.
+ *******************************************/
+inline RoaringContainer RoaringContainer :: combine(const RoaringContainer & lhs,
+                                                    const RoaringContainer & rhs, Op op)
+{
+   RoaringContainer out;
+
+   if (lhs.type == ARRAY && rhs.type == ARRAY)
+   {
+      const unsigned short * a = lhs.values.data();
+      const unsigned short * b = rhs.values.data();
+      switch (op)
+      {
+         case AND:
+            out.values.resize(min(lhs.card, rhs.card) + 4);
+            out.card = intersectSorted(a, lhs.card, b, rhs.card, out.values.data());
+            break;
+         case OR:
+            out.values.resize(lhs.card + rhs.card);
+            out.card = uniteSorted(a, lhs.card, b, rhs.card, out.values.data());
+            break;
+         case ANDNOT:
+            out.values.resize(lhs.card);
+            out.card = differenceSorted(a, lhs.card, b, rhs.card, out.values.data());
+            break;
+         case XOR:
+            out.values.resize(lhs.card + rhs.card);
+            out.card = symmetricDifferenceSorted(a, lhs.card, b, rhs.card, out.values.data());
+            break;
+      }
+      out.values.resize(out.card);
+      out.normalize();
+      return out;
+   }
+
+   if ((op == AND && (lhs.type == ARRAY || rhs.type == ARRAY)) ||
+       (op == ANDNOT && lhs.type == ARRAY))
+   {
+      const RoaringContainer & filtered = (lhs.type == ARRAY) ? lhs : rhs;
+      const RoaringContainer & other = (lhs.type == ARRAY) ? rhs : lhs;
+      bool keep = (op == AND);
+      for (int i = 0; i < filtered.card; i++)
+         if (other.contains(filtered.values[i]) == keep)
+            out.values.push_back(filtered.values[i]);
+      out.card = (int)out.values.size();
+      return out;
+   }
+
+   vector<unsigned long long> scratchA;
+   vector<unsigned long long> scratchB;
+   const unsigned long long * a = lhs.bitmap(scratchA);
+   const unsigned long long * b = rhs.bitmap(scratchB);
+
+   out.type = BITMAP;
+   out.words.resize(ROARING_WORDS);
+   for (int i = 0; i < ROARING_WORDS; i++)
+   {
+      unsigned long long w = 0;
+      switch (op)
+      {
+         case AND:    w = a[i] & b[i];  break;
+         case OR:     w = a[i] | b[i];  break;
+         case ANDNOT: w = a[i] & ~b[i]; break;
+         case XOR:    w = a[i] ^ b[i];  break;
+      }
+      out.words[i] = w;
+      out.card += popcount(w);
+   }
+   out.normalize();
+   return out;
+}
+
+/*******************************************
+ * RoaringSet :: locate
+ *******************************************/
+inline int RoaringSet :: locate(unsigned short key) const
+{
+   // appending in order is the common case
+   if (keys.empty() || keys.back() < key)
+      return (int)keys.size();
+   return (int)(lower_bound(keys.begin(), keys.end(), key) - keys.begin());
+}
+
+/*******************************************
+ * RoaringSet :: size
+ *******************************************/
+inline long long RoaringSet :: size() const
+{
+   long long num = 0;
+   for (size_t i = 0; i < containers.size(); i++)
+      num += containers[i].card;
+   return num;
+}
+
+/*******************************************
+ * RoaringSet :: insert
+ *******************************************/
+inline bool RoaringSet :: insert(unsigned int x)
+{
+   unsigned short key = (unsigned short)(x >> 16);
+   int i = locate(key);
+   if (i == (int)keys.size() || keys[i] != key)
+   {
+      keys.insert(keys.begin() + i, key);
+      containers.insert(containers.begin() + i, RoaringContainer());
+   }
+   return containers[i].insert((unsigned short)x);
+}
+
+/*******************************************
+ * RoaringSet :: erase
+ *******************************************/
+inline bool RoaringSet :: erase(unsigned int x)
+{
+   unsigned short key = (unsigned short)(x >> 16);
+   int i = locate(key);
+   if (i == (int)keys.size() || keys[i] != key)
+      return false;
+   if (!containers[i].erase((unsigned short)x))
+      return false;
+
+   if (containers[i].card == 0)
+   {
+      keys.erase(keys.begin() + i);
+      containers.erase(containers.begin() + i);
+   }
+   return true;
+}
+
+/*******************************************
+ * RoaringSet :: contains
+ *******************************************/
+inline bool RoaringSet :: contains(unsigned int x) const
+{
+   unsigned short key = (unsigned short)(x >> 16);
+   int i = locate(key);
+   return i < (int)keys.size() && keys[i] == key &&
+          containers[i].contains((unsigned short)x);
+}
+
+/*******************************************
+ * RoaringSet :: runOptimize
+ *******************************************/
+inline void RoaringSet :: runOptimize()
+{
+   for (size_t i = 0; i < containers.size(); i++)
+      containers[i].runOptimize();
+}
+
+/*******************************************
+ * RoaringSet :: combine
+ * Merge the two lists of keys.  A key on
+ * only one side keeps (OR, XOR, or ANDNOT
+ * from the left) or drops its container
+ * whole; a key on both combines the two.
+ *******************************************/
+inline RoaringSet RoaringSet :: combine(const RoaringSet & rhs, RoaringContainer::Op op) const
+{
+   bool keepLeft = (op != RoaringContainer::AND);
+   bool keepRight = (op == RoaringContainer::OR || op == RoaringContainer::XOR);
+
+   RoaringSet out;
+   size_t i = 0, j = 0;
+   while (i < keys.size() || j < rhs.keys.size())
+   {
+      if (j == rhs.keys.size() || (i < keys.size() && keys[i] < rhs.keys[j]))
+      {
+         if (keepLeft)
+         {
+            out.keys.push_back(keys[i]);
+            out.containers.push_back(containers[i]);
+         }
+         i++;
+      }
+      else if (i == keys.size() || rhs.keys[j] < keys[i])
+      {
+         if (keepRight)
+         {
+            out.keys.push_back(rhs.keys[j]);
+            out.containers.push_back(rhs.containers[j]);
+         }
+         j++;
+      }
+      else
+      {
+         RoaringContainer c = RoaringContainer::combine(containers[i], rhs.containers[j], op);
+         if (c.card)
+         {
+            out.keys.push_back(keys[i]);
+            out.containers.push_back(c);
+         }
+         i++;
+         j++;
+      }
+   }
+   return out;
+}
+
+/*******************************************
+ * RoaringSet :: operator ==
+ * Same values, whatever the containers.
+ *******************************************/
+inline bool RoaringSet :: operator == (const RoaringSet & rhs) const
+{
+   if (keys != rhs.keys)
+      return false;
+   for (size_t i = 0; i < containers.size(); i++)
+      if (containers[i].card != rhs.containers[i].card ||
+          RoaringContainer::combine(containers[i], rhs.containers[i],
+                                    RoaringContainer::XOR).card != 0)
+         return false;
+   return true;
+}
+
+/*******************************************
+ * RoaringSet :: serializedSize
+ *******************************************/
+inline long long RoaringSet :: serializedSize() const
+{
+   long long n = (long long)containers.size();
+   bool hasRun = false;
+   long long bytes = 0;
+   for (size_t i = 0; i < containers.size(); i++)
+   {
+      hasRun |= (containers[i].type == RoaringContainer::RUN);
+      bytes += containers[i].serializedSize();
+   }
+
+   if (hasRun)
+      return bytes + 4 + (n + 7) / 8 + 4 * n + (n >= 4 ? 4 * n : 0);
+   return bytes + 8 + 8 * n;
+}
+
+// little endian, byte at a time, so any machine reads any other's
+inline void roaringWrite(ostream & out, unsigned long long x, int bytes)
+{
+   for (int i = 0; i < bytes; i++)
+      out.put((char)((x >> (8 * i)) & 0xFF));
+}
+
+inline unsigned long long roaringRead(istream & in, int bytes) throw (const char *)
+{
+   unsigned long long x = 0;
+   for (int i = 0; i < bytes; i++)
+   {
+      int c = in.get();
+      if (c == EOF)
+         throw "ERROR: Unexpected end of serialized RoaringSet";
+      x |= (unsigned long long)(c & 0xFF) << (8 * i);
+   }
+   return x;
+}
+
+/*******************************************
+ * RoaringSet :: serialize
+ * The cookie (which says whether there are
+ * run containers, and with them how many
+ * containers), a bit per container for run
+ * or not, then key and count - 1 for each,
+ * where each container starts, and last the
+ * containers themselves.
+ *******************************************/
+inline void RoaringSet :: serialize(ostream & out) const throw (const char *)
+{
+   int n = (int)containers.size();
+   bool hasRun = false;
+   for (int i = 0; i < n; i++)
+      hasRun |= (containers[i].type == RoaringContainer::RUN);
+
+   long long offset;
+   if (hasRun)
+   {
+      roaringWrite(out, ROARING_COOKIE | ((unsigned long long)(n - 1) << 16), 4);
+      for (int byte = 0; byte < (n + 7) / 8; byte++)
+      {
+         int bits = 0;
+         for (int i = byte * 8; i < n && i < byte * 8 + 8; i++)
+            if (containers[i].type == RoaringContainer::RUN)
+               bits |= 1 << (i - byte * 8);
+         roaringWrite(out, bits, 1);
+      }
+      offset = 4 + (n + 7) / 8 + 4 * n + (n >= 4 ? 4 * n : 0);
+   }
+   else
+   {
+      roaringWrite(out, ROARING_COOKIE_NO_RUN, 4);
+      roaringWrite(out, n, 4);
+      offset = 8 + 8 * n;
+   }
+
+   for (int i = 0; i < n; i++)
+   {
+      roaringWrite(out, keys[i], 2);
+      roaringWrite(out, containers[i].card - 1, 2);
+   }
+
+   if (!hasRun || n >= 4)
+      for (int i = 0; i < n; i++)
+      {
+         roaringWrite(out, offset, 4);
+         offset += containers[i].serializedSize();
+      }
+
+   for (int i = 0; i < n; i++)
+   {
+      const RoaringContainer & c = containers[i];
+      switch (c.type)
+      {
+         case RoaringContainer::ARRAY:
+            for (int k = 0; k < c.card; k++)
+               roaringWrite(out, c.values[k], 2);
+            break;
+         case RoaringContainer::BITMAP:
+            for (int k = 0; k < ROARING_WORDS; k++)
+               roaringWrite(out, c.words[k], 8);
+            break;
+         case RoaringContainer::RUN:
+            roaringWrite(out, c.values.size() / 2, 2);
+            for (size_t k = 0; k < c.values.size(); k++)
+               roaringWrite(out, c.values[k], 2);
+            break;
+      }
+   }
+
+   if (!out)
+      throw "ERROR: Unable to write RoaringSet";
+}
+
+/*******************************************
+ * RoaringSet :: deserialize
+ * Without a run bit, a container of up to
+ * 4096 values is an array, else a bitmap.
+ *******************************************/
+inline RoaringSet RoaringSet :: deserialize(istream & in) throw (const char *)
+{
+   unsigned long long cookie = roaringRead(in, 4);
+   int n;
+   vector<bool> isRun;
+   bool hasRun = (cookie & 0xFFFF) == ROARING_COOKIE;
+   if (hasRun)
+   {
+      n = (int)(cookie >> 16) + 1;
+      isRun.resize(n);
+      for (int byte = 0; byte < (n + 7) / 8; byte++)
+      {
+         int bits = (int)roaringRead(in, 1);
+         for (int i = byte * 8; i < n && i < byte * 8 + 8; i++)
+            isRun[i] = (bits >> (i - byte * 8)) & 1;
+      }
+   }
+   else if (cookie == ROARING_COOKIE_NO_RUN)
+   {
+      n = (int)roaringRead(in, 4);
+      if (n < 0 || n > 65536)
+         throw "ERROR: Bad serialized RoaringSet";
+      isRun.resize(n);
+   }
+   else
+      throw "ERROR: Not a serialized RoaringSet";
+
+   RoaringSet set;
+   set.keys.resize(n);
+   set.containers.resize(n);
+   for (int i = 0; i < n; i++)
+   {
+      set.keys[i] = (unsigned short)roaringRead(in, 2);
+      set.containers[i].card = (int)roaringRead(in, 2) + 1;
+      if (i && set.keys[i] <= set.keys[i - 1])
+         throw "ERROR: Bad serialized RoaringSet";
+   }
+
+   // the offsets are only for skipping around, we read straight through
+   if (!hasRun || n >= 4)
+      in.ignore(4 * (streamsize)n);
+
+   for (int i = 0; i < n; i++)
+   {
+      RoaringContainer & c = set.containers[i];
+      if (isRun[i])
+      {
+         c.type = RoaringContainer::RUN;
+         int runs = (int)roaringRead(in, 2);
+         c.values.resize(2 * runs);
+         int card = 0;
+         for (int k = 0; k < 2 * runs; k++)
+            c.values[k] = (unsigned short)roaringRead(in, 2);
+         for (int k = 0; k < runs; k++)
+         {
+            if (c.values[2 * k] + c.values[2 * k + 1] > 65535 ||
+                (k && c.values[2 * k] <= c.values[2 * k - 2] + c.values[2 * k - 1]))
+               throw "ERROR: Bad serialized RoaringSet";
+            card += c.values[2 * k + 1] + 1;
+         }
+         c.card = card;
+      }
+      else if (c.card <= ROARING_ARRAY_MAX)
+      {
+         c.type = RoaringContainer::ARRAY;
+         c.values.resize(c.card);
+         for (int k = 0; k < c.card; k++)
+         {
+            c.values[k] = (unsigned short)roaringRead(in, 2);
+            if (k && c.values[k] <= c.values[k - 1])
+               throw "ERROR: Bad serialized RoaringSet";
+         }
+      }
+      else
+      {
+         c.type = RoaringContainer::BITMAP;
+         c.words.resize(ROARING_WORDS);
+         int card = 0;
+         for (int k = 0; k < ROARING_WORDS; k++)
+         {
+            c.words[k] = roaringRead(in, 8);
+            card += __builtin_popcountll(c.words[k]);
+         }
+         c.card = card;
+      }
+      if (c.card == 0)
+         throw "ERROR: Bad serialized RoaringSet";
+   }
+
+   if (!in)
+      throw "ERROR: Unexpected end of serialized RoaringSet";
+   return set;
+}
+
+#endif // ROARINGSET_H
@@ -6,8 +6,17 @@
 #ifndef Set_H
 #define Set_H
 
+#include "bloom.h"
+#include "parallelsort.h"
+#include "setexpr.h"
+#include "setops.h"
+#include <algorithm>
 #include <cassert>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <type_traits>
+#include <vector>
 
 using namespace std; // for debugging
 
@@ -29,27 +38,53 @@ public:
    T * data;          // dynamically allocated array of T
    int numItems;      // how many items are currently in the Set?
    int cap;           // how many items can I put on the Set before full?
+   BloomFilter * filter;              // optional, see enableFilter()
+   size_t (*filterHash)(const T &);   // how keys are hashed for the filter
 
    // Default constructor : empty and kinda useless
-   Set() : numItems(0), cap(0), data(NULL) {}
+   Set() : data(NULL), numItems(0), cap(0), filter(NULL), filterHash(NULL) {}
 
    // Copy constructor : copy it
    Set(const Set & rhs) throw (const char *);
    
    // Non-default constructor : pre-allocate
    Set(int cap) throw (const char *);
+
+   // Range constructor : bulk load [first, last), any order, duplicates ok
+   // (only for real iterators, so Set<int>(5, 7) is an error, not {7})
+   template <class Iterator, class = typename enable_if<is_convertible<
+      typename iterator_traits<Iterator>::iterator_category,
+      input_iterator_tag>::value>::type>
+   Set(Iterator first, Iterator last) throw (const char *)
+      : data(NULL), numItems(0), cap(0), filter(NULL), filterHash(NULL)
+                                          { insert_range(first, last); }
    
    // Destructor : free everything
-   ~Set()             { if (cap) delete [] data;    }
+   ~Set()             { if (cap) delete [] data; delete filter; }
 
    // Assignment operator
    Set <T> & operator=(Set <T> & rhs);
 
-   // Intersecting operator
-   Set <T> operator&&(Set <T> & rhs);
+   // Expression constructor : evaluate a && b, a || b, a - b, ...
+   // (see setexpr.h) in one pass
+   template <class E>
+   Set(const SetExpr<E> & expr) throw (const char *)
+      : data(NULL), numItems(0), cap(0), filter(NULL), filterHash(NULL)
+                                          { assign(expr); }
 
-   // Union operator
-   Set <T> operator||(Set <T> & rhs);
+   // Expression assignment : same, safe even if this Set is in expr
+   template <class E>
+   Set <T> & operator=(const SetExpr<E> & expr) throw (const char *)
+   {
+      assign(expr);
+      return *this;
+   }
+
+   // Set algebra, eager versions of the &&, || and - expressions
+   Set <T> intersect(const Set <T> & rhs) const throw (const char *);
+   Set <T> unite(const Set <T> & rhs) const throw (const char *);
+   Set <T> difference(const Set <T> & rhs) const throw (const char *);
+   Set <T> symmetric_difference(const Set <T> & rhs) const throw (const char *);
 
    // Is the Set empty?
    bool empty() const   { return numItems == 0; }
@@ -61,22 +96,51 @@ public:
    int capacity() const { return cap;           }
 
    // Clears the Set of items, not cap
-   void clear()         { numItems = 0; 	    }
+   void clear()         { numItems = 0; if (filter) filter->reset(0); }
 
    // Add an item to the Set
    void insert(const T & t) throw (const char *);
 
+   // Add every item of [first, last) in O(n log n + numItems)
+   template <class Iterator>
+   void insert_range(Iterator first, Iterator last) throw (const char *);
+
    // Remove an item from the Set
    void erase(int remove);
 
    // Search for an item in the Set
-   int find(const T & get);
+   int find(const T & get) const;
+
+   // Index of the first item not less than t (numItems if none)
+   int lower_bound(const T & t) const;
+
+   // Put a Bloom filter (see bloom.h) in front of find() so most
+   // misses skip the search.  Hash is only needed if you do this.
+   template <class Hash = hash<T> >
+   void enableFilter(int bitsPerKey = 10) throw (const char *);
+
+   // Take it away again
+   void disableFilter()   { delete filter; filter = NULL; }
+
+   // Of the finds that missed, the fraction the filter let through
+   double filterFalsePositiveRate() const
+   {
+      return filter ? filter->falsePositiveRate() : 0.0;
+   }
    
    // return an iterator to the beginning of the list
    SetIterator <T> begin() { return SetIterator<T>(data); }
 
    // return an iterator to the end of the list
    SetIterator <T> end() { return SetIterator<T>(data + numItems);}
+
+private:
+   // stream an expression into a fresh buffer, then take it
+   template <class E>
+   void assign(const SetExpr<E> & expr) throw (const char *);
+
+   // build the filter again from the items
+   void refilter() throw (const char *);
 };
 
 
@@ -140,9 +204,17 @@ class SetIterator
  *******************************************/
 template <class T>
 Set <T> :: Set(const Set <T> & rhs) throw (const char *)
+   : filter(NULL), filterHash(NULL)
 {
    assert(rhs.cap >= 0);
 
+   // the filter comes along with the items
+   if (rhs.filter)
+   {
+      filter = new BloomFilter(*rhs.filter);
+      filterHash = rhs.filterHash;
+   }
+
    // do nothing if there is nothing to do
    if (rhs.cap == 0)
    {
@@ -158,6 +230,7 @@ Set <T> :: Set(const Set <T> & rhs) throw (const char *)
    }
    catch (std::bad_alloc)
    {
+      delete filter;
       throw "ERROR: Unable to allocate buffer";
    }
    
@@ -177,6 +250,7 @@ Set <T> :: Set(const Set <T> & rhs) throw (const char *)
  **********************************************/
 template <class T>
 Set <T> :: Set(int cap) throw (const char *)
+   : filter(NULL), filterHash(NULL)
 {
    assert(cap >= 0);
    
@@ -229,54 +303,98 @@ Set <T> & Set <T> :: operator=(Set <T> & rhs)
       data[i] = rhs.data[i];
    }
 
+   refilter();
    return *this;
 }
 
 /************************************
-* Set :: operator&&
-* Intersects two sets.
-* Matching values stay.
+* Set :: assign
+* Walks the expression's cursor once.
+* bound() is never less than the
+* answer, so one allocation does it.
 ************************************/
 template <class T>
-Set <T> Set <T> :: operator&&(Set <T> & rhs)
+template <class E>
+void Set <T> :: assign(const SetExpr<E> & expr) throw (const char *)
 {
-	Set <T> intersect;
-	for (int i = 0; i < numItems; i++)
-	{
-      if (rhs.find(data[i]) != -1)  // Can we find a match in the rhs?
-         intersect.insert(data[i]); // We have a match!
-	}
+   int bound = expr.self().bound();
+   if (bound < 1)
+      bound = 1;
 
-   return intersect;
+   T * nData;
+   try
+   {
+      nData = new T[bound];
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate buffer";
+   }
+
+   int k = 0;
+   for (typename E::Cursor c = expr.self().cursor(); c.valid(); c.next())
+      nData[k++] = c.value();
+
+   delete [] data;
+   data = nData;
+   cap = bound;
+   numItems = k;
+   refilter();
 }
 
 /************************************
-* Set :: operator||
-* Unifies two sets.  Everything
-* except duplicate values stays.
+* Set :: intersect
+* Matching values stay.  Lopsided
+* Sets gallop through the bigger one.
 ************************************/
 template <class T>
-Set <T> Set <T> :: operator||(Set <T> & rhs)
+Set <T> Set <T> :: intersect(const Set <T> & rhs) const throw (const char *)
 {
-	Set <T> unionSet;
-   int limit = 0;
-
-   while (data[limit]) // everything in this set
-   {
-      unionSet.insert(data[limit]);
-      limit++;
-   }
+   // the kernels may write a few past the answer
+   Set <T> result((numItems < rhs.numItems ? numItems : rhs.numItems) + 4);
+   result.numItems = intersectSorted(data, numItems, rhs.data, rhs.numItems,
+                                     result.data);
+   return result;
+}
 
-   limit = 0;
-   while (rhs.data[limit]) // everything in this set
-   {
+/************************************
+* Set :: unite
+* Everything except duplicate values
+* stays.
+************************************/
+template <class T>
+Set <T> Set <T> :: unite(const Set <T> & rhs) const throw (const char *)
+{
+   Set <T> result(numItems + rhs.numItems);
+   result.numItems = uniteSorted(data, numItems, rhs.data, rhs.numItems,
+                                 result.data);
+   return result;
+}
 
-   	// insert() will automatically take duplicates out
-      unionSet.insert(rhs.data[limit]);
-      limit++;
-   }
+/************************************
+* Set :: difference
+* Values in this Set but not in rhs.
+************************************/
+template <class T>
+Set <T> Set <T> :: difference(const Set <T> & rhs) const throw (const char *)
+{
+   Set <T> result(numItems);
+   result.numItems = differenceSorted(data, numItems, rhs.data, rhs.numItems,
+                                      result.data);
+   return result;
+}
 
-   return unionSet;
+/************************************
+* Set :: symmetric_difference
+* Values in exactly one of the Sets.
+************************************/
+template <class T>
+Set <T> Set <T> :: symmetric_difference(const Set <T> & rhs) const throw (const char *)
+{
+   Set <T> result(numItems + rhs.numItems);
+   result.numItems = symmetricDifferenceSorted(data, numItems, rhs.data,
+                                               rhs.numItems, result.data);
+   return result;
 }
 
 /***************************************************
@@ -312,26 +430,23 @@ void Set <T> :: insert(const T & t) throw (const char *)
          data = nData;
       }
 
-      int add = find(t); // Is it already in the Set?
-      if (add == -1)
+      int place = lower_bound(t); // where it is, or where it goes
+      if (place == numItems || !(data[place] == t))
       {
-      	int place = numItems;  // Initially could add item to the end
-      	for (int i = 0; i < numItems; i++)
-	      {
-	      	if (data[i] > t)
-	      	{
-	      		place = i;
-	      		break;
-	      	}
-	      }
-	      for (int i = numItems - 1; i >= place; i--)
-	      {
-	      	data[i + 1] = data[i]; // shift data to the right
-	      }
-	      // Now we can insert the new item
-	      data[place] = t;
-	      numItems++;
-	   }
+         // shift data to the right in one pass
+         move_backward(data + place, data + numItems, data + numItems + 1);
+
+         // Now we can insert the new item
+         data[place] = t;
+         numItems++;
+
+         if (filter)
+         {
+            filter->add(filterHash(t));
+            if (filter->stale())
+               refilter();
+         }
+      }
    }
    catch (std::bad_alloc)
    {
@@ -339,6 +454,55 @@ void Set <T> :: insert(const T & t) throw (const char *)
    }
 }
 
+/***************************************************
+ * Set :: insert_range
+ * Sorts a copy of the input (on the ThreadPool when
+ * it is big), then makes one pass that merges it
+ * with what we already have and drops duplicates.
+ **************************************************/
+template <class T>
+template <class Iterator>
+void Set <T> :: insert_range(Iterator first, Iterator last) throw (const char *)
+{
+   try
+   {
+      vector<T> items(first, last);
+      if (items.empty())
+         return;
+      parallelSort(&items[0], &items[0] + items.size());
+
+      int num = (int)items.size();
+      T * nData = new T[numItems + num];
+      int i = 0;        // next of ours
+      int j = 0;        // next of theirs
+      int k = 0;        // next free in nData
+
+      while (i < numItems || j < num)
+      {
+         // take the smaller, ours on a tie
+         const T * next;
+         if (j == num || (i < numItems && !(items[j] < data[i])))
+            next = &data[i++];
+         else
+            next = &items[j++];
+
+         // skip it if it is the same as the last one we kept
+         if (k == 0 || nData[k - 1] < *next)
+            nData[k++] = *next;
+      }
+
+      delete [] data;
+      data = nData;
+      cap = numItems + num;
+      numItems = k;
+      refilter();
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate a new buffer for set";
+   }
+}
+
 /***************************************************
  * Set :: erase
  * Takes an integer parameter as an index for the
@@ -347,19 +511,43 @@ void Set <T> :: insert(const T & t) throw (const char *)
 template <class T>
 void Set <T> :: erase(int remove)
 {
+	assert(remove >= 0 && remove < numItems);
+
+	// remove item and shift to the left in one pass
+	std::move(data + remove + 1, data + numItems, data + remove);
 	numItems--;
-	for (int i = remove; i < numItems; i++)
+
+	if (filter)
 	{
-		// remove item and shift to the left
-		data[i] = data[i + 1];
+		filter->erased();
+		if (filter->stale())
+			refilter();
 	}
+}
 
-	// gotta get the last one
-	if (remove == numItems)
+/***************************************************
+ * Set :: lower_bound
+ * Binary search over [0, numItems).  The loop
+ * always runs log n times and picks the next half
+ * with a conditional move instead of a branch, so
+ * there is nothing for the CPU to mispredict.
+ **************************************************/
+template <class T>
+int Set <T> :: lower_bound(const T & t) const
+{
+	if (numItems == 0)
+		return 0;
+
+	const T * base = data;
+	int n = numItems;
+	while (n > 1)
 	{
-		data[remove] = "\0";
+		int half = n / 2;
+		base = (base[half - 1] < t) ? base + half : base;
+		n -= half;
 	}
 
+	return (int)(base - data) + (*base < t);
 }
 
 /***************************************************
@@ -368,16 +556,59 @@ void Set <T> :: erase(int remove)
  * the Set.  If the item is not found, it returns -1.
  **************************************************/
 template <class T>
-int Set <T> :: find(const T & get)
+int Set <T> :: find(const T & get) const
+{
+	if (filter && !filter->mayContain(filterHash(get)))
+		return -1; // certainly not here
+
+	int i = lower_bound(get);
+	if (i < numItems && data[i] == get)
+		return i; // found it
+
+	if (filter)
+		filter->falsePositive();
+	return -1;
+}
+
+/***************************************************
+ * Set :: enableFilter
+ * Replaces any filter we had with a new one with
+ * bitsPerKey bits for each key.
+ **************************************************/
+template <class T>
+template <class Hash>
+void Set <T> :: enableFilter(int bitsPerKey) throw (const char *)
 {
-	for (int i = 0; i < cap; i++)
+	BloomFilter * nFilter;
+	try
+	{
+		nFilter = new BloomFilter(bitsPerKey);
+	}
+	catch (std::bad_alloc)
 	{
-		if (data[i] == get)
-			// found it
-			return i;
+		throw "ERROR: Unable to allocate filter";
 	}
 
-	return -1;
+	delete filter;
+	filter = nFilter;
+	filterHash = &bloomHash<T, Hash>;
+	refilter();
+}
+
+/***************************************************
+ * Set :: refilter
+ * Sized for twice what we have now so growing
+ * doesn't rebuild it again right away.
+ **************************************************/
+template <class T>
+void Set <T> :: refilter() throw (const char *)
+{
+	if (!filter)
+		return;
+
+	filter->reset(2 * numItems);
+	for (int i = 0; i < numItems; i++)
+		filter->add(filterHash(data[i]));
 }
 
 #endif // Set_H
\ No newline at end of file
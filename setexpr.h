@@ -0,0 +1,323 @@
+/***************************************************************
+ * File: setexpr.h
+ * Author: Ryan Walker
+ * Purpose: Lazy set algebra for Set.
+ *    a && b, a || b and a - b don't build a Set.  They build a
+ * small expression object that remembers the operation and its
+ * operands, so (a && b) || (c && d) is a tree of four leaves and
+ * three operations and nothing has been computed yet.  The tree
+ * is evaluated in one streaming pass when it is assigned to a Set
+ * (or used to construct one), or it can be walked directly with
+ * begin()/end() without ever making a Set.
+ *
+ *    Every node of the tree hands out a cursor that can step to
+ * its next item or seek forward to the first item not less than
+ * some value.  Intersections leapfrog their operands with seek,
+ * so a small operand lets the big ones gallop.
+ *
+ *    Leaves hold a reference to their Set, so the Sets must live
+ * at least as long as the expression.
+ ***************************************************************/
+#ifndef SETEXPR_H
+#define SETEXPR_H
+
+#include "setops.h"
+#include <cassert>
+#include <iostream>
+
+using namespace std;
+
+// forward declaration for Set
+template <class T>
+class Set;
+
+/************************************************
+ * SetExpr
+ * Base of every expression node.  Derived is the
+ * node itself, so the operators can take any kind
+ * of node without virtual calls.
+ ***********************************************/
+template <class Derived>
+class SetExpr
+{
+public:
+   const Derived & self() const { return static_cast<const Derived &>(*this); }
+};
+
+/************************************************
+ * SetExprIterator
+ * Walks an expression's cursor.  The end iterator
+ * is the one with no cursor.
+ ***********************************************/
+template <class Cursor>
+class SetExprIterator
+{
+public:
+   // the end
+   SetExprIterator() : atEnd(true) {}
+
+   // the beginning
+   SetExprIterator(const Cursor & c) : cursor(c), atEnd(!c.valid()) {}
+
+   // not equals operator, only good against end()
+   bool operator != (const SetExprIterator & rhs) const { return atEnd != rhs.atEnd; }
+   bool operator == (const SetExprIterator & rhs) const { return atEnd == rhs.atEnd; }
+
+   // dereference operator
+   const typename Cursor::value_type & operator * () const { return cursor.value(); }
+
+   // prefix increment
+   SetExprIterator & operator ++ ()
+   {
+      cursor.next();
+      atEnd = !cursor.valid();
+      return *this;
+   }
+
+private:
+   Cursor cursor;
+   bool atEnd;
+};
+
+/************************************************
+ * SetLeaf
+ * A Set in an expression.
+ ***********************************************/
+template <class T>
+class SetLeaf : public SetExpr< SetLeaf<T> >
+{
+public:
+   typedef T value_type;
+
+   class Cursor
+   {
+   public:
+      typedef T value_type;
+      Cursor() : data(NULL), i(0), num(0) {}
+      Cursor(const T * data, int num) : data(data), i(0), num(num) {}
+
+      bool valid() const          { return i < num;  }
+      const T & value() const     { return data[i];  }
+      void next()                 { i++;             }
+      void seek(const T & t)      { i = gallop(data, i, num, t); }
+
+   private:
+      const T * data;
+      int i;
+      int num;
+   };
+
+   SetLeaf(const Set<T> & set) : set(set) {}
+
+   Cursor cursor() const        { return Cursor(set.data, set.numItems); }
+   int bound() const            { return set.numItems; }
+
+private:
+   const Set<T> & set;
+};
+
+/************************************************
+ * SetAnd
+ * Items in both operands.
+ ***********************************************/
+template <class L, class R>
+class SetAnd : public SetExpr< SetAnd<L, R> >
+{
+public:
+   typedef typename L::value_type value_type;
+
+   class Cursor
+   {
+   public:
+      typedef typename L::value_type value_type;
+      Cursor() {}
+      Cursor(const typename L::Cursor & l, const typename R::Cursor & r) : l(l), r(r)
+      {
+         align();
+      }
+
+      bool valid() const               { return l.valid() && r.valid(); }
+      const value_type & value() const { return l.value(); }
+      void next()                      { l.next(); r.next(); align(); }
+      void seek(const value_type & t)  { l.seek(t); r.seek(t); align(); }
+
+   private:
+      // leapfrog until both sides are on the same item
+      void align()
+      {
+         while (l.valid() && r.valid())
+         {
+            if (l.value() < r.value())
+               l.seek(r.value());
+            else if (r.value() < l.value())
+               r.seek(l.value());
+            else
+               break;
+         }
+      }
+
+      typename L::Cursor l;
+      typename R::Cursor r;
+   };
+
+   SetAnd(const L & l, const R & r) : l(l), r(r) {}
+
+   Cursor cursor() const   { return Cursor(l.cursor(), r.cursor()); }
+   int bound() const       { return l.bound() < r.bound() ? l.bound() : r.bound(); }
+
+   SetExprIterator<Cursor> begin() const { return SetExprIterator<Cursor>(cursor()); }
+   SetExprIterator<Cursor> end() const   { return SetExprIterator<Cursor>(); }
+
+private:
+   L l;
+   R r;
+};
+
+/************************************************
+ * SetOr
+ * Items in either operand, once each.
+ ***********************************************/
+template <class L, class R>
+class SetOr : public SetExpr< SetOr<L, R> >
+{
+public:
+   typedef typename L::value_type value_type;
+
+   class Cursor
+   {
+   public:
+      typedef typename L::value_type value_type;
+      Cursor() {}
+      Cursor(const typename L::Cursor & l, const typename R::Cursor & r) : l(l), r(r) {}
+
+      bool valid() const { return l.valid() || r.valid(); }
+
+      // the smaller of the two fronts
+      const value_type & value() const
+      {
+         if (!l.valid())
+            return r.value();
+         if (!r.valid() || !(r.value() < l.value()))
+            return l.value();
+         return r.value();
+      }
+
+      // step past the current item on whichever sides have it
+      void next()
+      {
+         value_type current = value();
+         if (l.valid() && !(current < l.value()))
+            l.next();
+         if (r.valid() && !(current < r.value()))
+            r.next();
+      }
+
+      void seek(const value_type & t) { l.seek(t); r.seek(t); }
+
+   private:
+      typename L::Cursor l;
+      typename R::Cursor r;
+   };
+
+   SetOr(const L & l, const R & r) : l(l), r(r) {}
+
+   Cursor cursor() const   { return Cursor(l.cursor(), r.cursor()); }
+   int bound() const       { return l.bound() + r.bound(); }
+
+   SetExprIterator<Cursor> begin() const { return SetExprIterator<Cursor>(cursor()); }
+   SetExprIterator<Cursor> end() const   { return SetExprIterator<Cursor>(); }
+
+private:
+   L l;
+   R r;
+};
+
+/************************************************
+ * SetMinus
+ * Items in the left operand but not the right.
+ ***********************************************/
+template <class L, class R>
+class SetMinus : public SetExpr< SetMinus<L, R> >
+{
+public:
+   typedef typename L::value_type value_type;
+
+   class Cursor
+   {
+   public:
+      typedef typename L::value_type value_type;
+      Cursor() {}
+      Cursor(const typename L::Cursor & l, const typename R::Cursor & r) : l(l), r(r)
+      {
+         skip();
+      }
+
+      bool valid() const               { return l.valid(); }
+      const value_type & value() const { return l.value(); }
+      void next()                      { l.next(); skip(); }
+      void seek(const value_type & t)  { l.seek(t); skip(); }
+
+   private:
+      // step l past anything r also has
+      void skip()
+      {
+         while (l.valid())
+         {
+            r.seek(l.value());
+            if (r.valid() && !(l.value() < r.value()))
+               l.next();
+            else
+               break;
+         }
+      }
+
+      typename L::Cursor l;
+      typename R::Cursor r;
+   };
+
+   SetMinus(const L & l, const R & r) : l(l), r(r) {}
+
+   Cursor cursor() const   { return Cursor(l.cursor(), r.cursor()); }
+   int bound() const       { return l.bound(); }
+
+   SetExprIterator<Cursor> begin() const { return SetExprIterator<Cursor>(cursor()); }
+   SetExprIterator<Cursor> end() const   { return SetExprIterator<Cursor>(); }
+
+private:
+   L l;
+   R r;
+};
+
+/***************************************************
+ * The operators.  Each takes two Sets, two
+ * expressions, or one of each.
+ **************************************************/
+#define SET_EXPR_OPERATOR(OP, NODE)                                               \
+template <class T>                                                                \
+NODE< SetLeaf<T>, SetLeaf<T> > operator OP (const Set<T> & l, const Set<T> & r)   \
+{                                                                                 \
+   return NODE< SetLeaf<T>, SetLeaf<T> >(SetLeaf<T>(l), SetLeaf<T>(r));           \
+}                                                                                 \
+template <class L, class R>                                                       \
+NODE<L, R> operator OP (const SetExpr<L> & l, const SetExpr<R> & r)               \
+{                                                                                 \
+   return NODE<L, R>(l.self(), r.self());                                         \
+}                                                                                 \
+template <class T, class R>                                                       \
+NODE< SetLeaf<T>, R > operator OP (const Set<T> & l, const SetExpr<R> & r)        \
+{                                                                                 \
+   return NODE< SetLeaf<T>, R >(SetLeaf<T>(l), r.self());                         \
+}                                                                                 \
+template <class L, class T>                                                       \
+NODE< L, SetLeaf<T> > operator OP (const SetExpr<L> & l, const Set<T> & r)        \
+{                                                                                 \
+   return NODE< L, SetLeaf<T> >(l.self(), SetLeaf<T>(r));                         \
+}
+
+SET_EXPR_OPERATOR(&&, SetAnd)
+SET_EXPR_OPERATOR(||, SetOr)
+SET_EXPR_OPERATOR(-,  SetMinus)
+
+#undef SET_EXPR_OPERATOR
+
+#endif // SETEXPR_H
@@ -0,0 +1,301 @@
+/***************************************************************
+ * File: setops.h
+ * Author: Ryan Walker
+ * Purpose: Set algebra on sorted arrays without duplicates.
+ *    Each function walks its two inputs once and writes the
+ * answer into out, returning how many items it wrote.  out must
+ * have room for the worst case (noted on each function).  These
+ * are what Set's operators are built on.
+ *
+ *    When one side is much smaller than the other the intersection
+ * gallops: each small item is found in the big side with an
+ * exponential then binary search, O(m log(n / m)) instead of
+ * O(n + m).  32-bit integers get an SSE kernel that compares four
+ * against four at a time when the compiler allows SSSE3.
+ ***************************************************************/
+#ifndef SETOPS_H
+#define SETOPS_H
+
+#include <cassert>
+#include <iostream>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+using namespace std;
+
+// how lopsided the inputs must be before intersect gallops
+#define GALLOP_RATIO 32
+
+/***************************************************
+ * gallop
+ * Index of the first item in [lo, num) of data not
+ * less than t.  Steps 1, 2, 4, ... from lo to bracket
+ * it, then binary searches the bracket, so it is
+ * cheap when the answer is close to lo.
+ **************************************************/
+template <class T>
+int gallop(const T * data, int lo, int num, const T & t)
+{
+   if (lo >= num || !(data[lo] < t))
+      return lo;
+
+   // data[lo] < t: find hi with data[hi] >= t (or the end)
+   int step = 1;
+   int hi = lo + 1;
+   while (hi < num && data[hi] < t)
+   {
+      lo = hi;
+      step *= 2;
+      hi = lo + step;
+   }
+   if (hi > num)
+      hi = num;
+
+   // data[lo] < t <= data[hi]
+   while (hi - lo > 1)
+   {
+      int mid = lo + (hi - lo) / 2;
+      if (data[mid] < t)
+         lo = mid;
+      else
+         hi = mid;
+   }
+   return hi;
+}
+
+/***************************************************
+ * intersectGallop
+ * For each of the few items of small, gallop through
+ * big from where the last one was found.
+ * out needs room for numSmall items.
+ **************************************************/
+template <class T>
+int intersectGallop(const T * small, int numSmall,
+                    const T * big, int numBig, T * out)
+{
+   int k = 0;
+   int j = 0;
+   for (int i = 0; i < numSmall && j < numBig; i++)
+   {
+      j = gallop(big, j, numBig, small[i]);
+      if (j < numBig && !(small[i] < big[j]))
+         out[k++] = small[i];
+   }
+   return k;
+}
+
+/***************************************************
+ * intersectMerge
+ * The plain merge walk.  out needs room for the
+ * smaller of numA and numB.
+ **************************************************/
+template <class T>
+int intersectMerge(const T * a, int numA, const T * b, int numB, T * out)
+{
+   int i = 0, j = 0, k = 0;
+   while (i < numA && j < numB)
+   {
+      if (a[i] < b[j])
+         i++;
+      else if (b[j] < a[i])
+         j++;
+      else
+      {
+         out[k++] = a[i];
+         i++;
+         j++;
+      }
+   }
+   return k;
+}
+
+#ifdef __SSSE3__
+/***************************************************
+ * intersectSSE
+ * Loads four of a and four of b, compares a against
+ * all four rotations of b, and packs the matches of
+ * a to the front with one byte shuffle.  Whichever
+ * block ends lower moves on.  Writes up to four past
+ * the answer, so out needs room for min + 4.
+ **************************************************/
+template <class T>
+int intersectSSE(const T * a, int numA, const T * b, int numB, T * out)
+{
+   // byte shuffles that pack the lanes set in a 4-bit mask to the front
+   struct PackTable
+   {
+      unsigned char pack[16][16];
+      int count[16];
+
+      PackTable()
+      {
+         for (int mask = 0; mask < 16; mask++)
+         {
+            int n = 0;
+            for (int lane = 0; lane < 4; lane++)
+               if (mask & (1 << lane))
+               {
+                  for (int byte = 0; byte < 4; byte++)
+                     pack[mask][n * 4 + byte] = (unsigned char)(lane * 4 + byte);
+                  n++;
+               }
+            for (int rest = n * 4; rest < 16; rest++)
+               pack[mask][rest] = 0x80;   // zero the rest
+            count[mask] = n;
+         }
+      }
+   };
+   static const PackTable table;
+
+   int i = 0, j = 0, k = 0;
+   int endA = numA & ~3;
+   int endB = numB & ~3;
+   while (i < endA && j < endB)
+   {
+      __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+      __m128i vb = _mm_loadu_si128((const __m128i *)(b + j));
+
+      __m128i hit = _mm_cmpeq_epi32(va, vb);
+      hit = _mm_or_si128(hit, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+      hit = _mm_or_si128(hit, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+      hit = _mm_or_si128(hit, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+
+      int mask = _mm_movemask_ps(_mm_castsi128_ps(hit));
+      __m128i packed = _mm_shuffle_epi8(va, _mm_loadu_si128((const __m128i *)table.pack[mask]));
+      _mm_storeu_si128((__m128i *)(out + k), packed);
+      k += table.count[mask];
+
+      T lastA = a[i + 3];
+      T lastB = b[j + 3];
+      if (!(lastB < lastA))
+         i += 4;
+      if (!(lastA < lastB))
+         j += 4;
+   }
+
+   // finish the ragged ends the plain way
+   return k + intersectMerge(a + i, numA - i, b + j, numB - j, out + k);
+}
+#endif // __SSSE3__
+
+/***************************************************
+ * intersectSorted
+ * out needs room for min(numA, numB) + 4.
+ **************************************************/
+template <class T>
+int intersectSorted(const T * a, int numA, const T * b, int numB, T * out)
+{
+   if ((long long)numA * GALLOP_RATIO < numB)
+      return intersectGallop(a, numA, b, numB, out);
+   if ((long long)numB * GALLOP_RATIO < numA)
+      return intersectGallop(b, numB, a, numA, out);
+   return intersectMerge(a, numA, b, numB, out);
+}
+
+#ifdef __SSSE3__
+/***************************************************
+ * intersectSorted (32-bit integers)
+ * Same, but the balanced case uses the SSE kernel.
+ **************************************************/
+inline int intersectSorted(const int * a, int numA, const int * b, int numB, int * out)
+{
+   if ((long long)numA * GALLOP_RATIO < numB)
+      return intersectGallop(a, numA, b, numB, out);
+   if ((long long)numB * GALLOP_RATIO < numA)
+      return intersectGallop(b, numB, a, numA, out);
+   return intersectSSE(a, numA, b, numB, out);
+}
+
+inline int intersectSorted(const unsigned int * a, int numA,
+                           const unsigned int * b, int numB, unsigned int * out)
+{
+   if ((long long)numA * GALLOP_RATIO < numB)
+      return intersectGallop(a, numA, b, numB, out);
+   if ((long long)numB * GALLOP_RATIO < numA)
+      return intersectGallop(b, numB, a, numA, out);
+   return intersectSSE(a, numA, b, numB, out);
+}
+#endif // __SSSE3__
+
+/***************************************************
+ * uniteSorted
+ * out needs room for numA + numB.
+ **************************************************/
+template <class T>
+int uniteSorted(const T * a, int numA, const T * b, int numB, T * out)
+{
+   int i = 0, j = 0, k = 0;
+   while (i < numA && j < numB)
+   {
+      if (a[i] < b[j])
+         out[k++] = a[i++];
+      else if (b[j] < a[i])
+         out[k++] = b[j++];
+      else
+      {
+         out[k++] = a[i++];
+         j++;
+      }
+   }
+   while (i < numA)
+      out[k++] = a[i++];
+   while (j < numB)
+      out[k++] = b[j++];
+   return k;
+}
+
+/***************************************************
+ * differenceSorted
+ * What is in a but not in b.  out needs room for numA.
+ **************************************************/
+template <class T>
+int differenceSorted(const T * a, int numA, const T * b, int numB, T * out)
+{
+   int i = 0, j = 0, k = 0;
+   while (i < numA && j < numB)
+   {
+      if (a[i] < b[j])
+         out[k++] = a[i++];
+      else if (b[j] < a[i])
+         j++;
+      else
+      {
+         i++;
+         j++;
+      }
+   }
+   while (i < numA)
+      out[k++] = a[i++];
+   return k;
+}
+
+/***************************************************
+ * symmetricDifferenceSorted
+ * What is in exactly one of a and b.  out needs
+ * room for numA + numB.
+ **************************************************/
+template <class T>
+int symmetricDifferenceSorted(const T * a, int numA, const T * b, int numB, T * out)
+{
+   int i = 0, j = 0, k = 0;
+   while (i < numA && j < numB)
+   {
+      if (a[i] < b[j])
+         out[k++] = a[i++];
+      else if (b[j] < a[i])
+         out[k++] = b[j++];
+      else
+      {
+         i++;
+         j++;
+      }
+   }
+   while (i < numA)
+      out[k++] = a[i++];
+   while (j < numB)
+      out[k++] = b[j++];
+   return k;
+}
+
+#endif // SETOPS_H
@@ -0,0 +1,441 @@
+/***************************************************************
+ * File: skiplist.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the ConcurrentSkipList
+ *    class.  An ordered map that many threads can insert into,
+ * erase from and read at the same time without a lock.  Each
+ * SkipNode is a tower: a node.h-style pNext pointer for every
+ * level it is on.  Level 0 holds every key in order and each
+ * level up skips about three quarters of the one below it.
+ *
+ *    Deleting marks the low bit of a node's pNext pointers, top
+ * level down; whoever marks level 0 has erased it.  Searches
+ * unlink marked nodes they walk past, and the eraser hands the
+ * node to Epoch::retire() once it is off every level.
+ *
+ *    insert, find and lower_bound never wait on another thread.
+ * erase can: a node whose insert is still linking its upper levels
+ * can't be unlinked yet, so the eraser yields until it is done.
+ ***************************************************************/
+#ifndef SKIPLIST_H
+#define SKIPLIST_H
+
+#include "epoch.h"
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+/************************************************
+ * SkipNode
+ * One key/value pair and its tower of links.
+ * A link is a SkipNode pointer with the low bit
+ * used as the "being deleted" mark.
+ ***********************************************/
+template <class K, class V>
+class SkipNode
+{
+public:
+   K key;
+   V value;
+   int topLevel;                     // highest level this node is on
+   atomic<bool> fullyLinked;         // has insert finished linking every level?
+   atomic<uintptr_t> * pNext;        // pNext[0..topLevel]
+
+   SkipNode(const K & key, const V & value, int topLevel)
+      : key(key), value(value), topLevel(topLevel), fullyLinked(false)
+   {
+      pNext = new atomic<uintptr_t>[topLevel + 1];
+      for (int i = 0; i <= topLevel; i++)
+         pNext[i].store(0, memory_order_relaxed);
+   }
+
+   ~SkipNode()          { delete [] pNext; }
+
+   // pull apart and put together a marked link
+   static SkipNode * ptr(uintptr_t link)   { return (SkipNode *)(link & ~(uintptr_t)1); }
+   static bool marked(uintptr_t link)      { return (link & 1) != 0; }
+   static uintptr_t mark(SkipNode * node)  { return (uintptr_t)node | 1; }
+   static uintptr_t link(SkipNode * node)  { return (uintptr_t)node;     }
+
+   // is this node erased, or being erased?
+   bool deleted() const { return marked(pNext[0].load(memory_order_acquire)); }
+};
+
+// forward declaration for the iterator
+template <class K, class V>
+class SkipListIterator;
+
+/************************************************
+ * ConcurrentSkipList
+ * insert, erase, find and lower_bound are all
+ * O(log n) expected.  All but erase are lock-
+ * free (see above).  Keys are unique; a value
+ * never changes once inserted.
+ ***********************************************/
+template <class K, class V>
+class ConcurrentSkipList
+{
+public:
+   static const int MAX_LEVEL = 24;   // enough for 4^24 keys
+
+   // default constructor : just the head tower
+   ConcurrentSkipList() : count(0)
+   {
+      head = new SkipNode<K, V>(K(), V(), MAX_LEVEL - 1);
+   }
+
+   // destructor : no other thread may be using the list
+   ~ConcurrentSkipList();
+
+   // add key if it is not already there
+   bool insert(const K & key, const V & value);
+
+   // remove key if it is there
+   bool erase(const K & key);
+
+   // is key there?  If so, copy out its value
+   bool find(const K & key, V & value) const;
+   bool contains(const K & key) const { V v; return find(key, v); }
+
+   // how many keys, give or take the operations in flight
+   long size() const    { return count.load(memory_order_relaxed); }
+   bool empty() const   { return size() == 0; }
+
+   // walk the keys in order
+   SkipListIterator <K, V> begin() const;
+   SkipListIterator <K, V> end() const  { return SkipListIterator <K, V> (NULL); }
+
+   // the first key not less than key
+   SkipListIterator <K, V> lower_bound(const K & key) const;
+
+private:
+   // find where key goes on every level, unlinking marked nodes on
+   // the way.  Returns true if an unmarked node has key.
+   bool locate(const K & key, SkipNode<K, V> ** preds, SkipNode<K, V> ** succs);
+
+   // the first unmarked node with a key not less than key
+   SkipNode<K, V> * seek(const K & key) const;
+
+   // a random level, each one a quarter as likely as the last
+   static int randomLevel();
+
+   // no copying
+   ConcurrentSkipList(const ConcurrentSkipList & rhs);
+   ConcurrentSkipList & operator = (const ConcurrentSkipList & rhs);
+
+   SkipNode<K, V> * head;     // sentinel tower, its key is never looked at
+   atomic<long> count;
+};
+
+/*******************************************
+ * ConcurrentSkipList :: DESTRUCTOR
+ *******************************************/
+template <class K, class V>
+ConcurrentSkipList <K, V> :: ~ConcurrentSkipList()
+{
+   SkipNode<K, V> * node = head;
+   while (node)
+   {
+      SkipNode<K, V> * next = SkipNode<K, V>::ptr(node->pNext[0].load());
+      delete node;
+      node = next;
+   }
+}
+
+/*******************************************
+ * ConcurrentSkipList :: randomLevel
+ *******************************************/
+template <class K, class V>
+int ConcurrentSkipList <K, V> :: randomLevel()
+{
+   static thread_local unsigned int seed = 0;
+   if (seed == 0)
+      seed = (unsigned int)(uintptr_t)&seed | 1;
+
+   seed ^= seed << 13;
+   seed ^= seed >> 17;
+   seed ^= seed << 5;
+
+   int level = 0;
+   unsigned int bits = seed;
+   while ((bits & 3) == 0 && level < MAX_LEVEL - 1)
+   {
+      level++;
+      bits >>= 2;
+   }
+   return level;
+}
+
+/*******************************************
+ * ConcurrentSkipList :: locate
+ * If the CAS to unlink a marked node fails,
+ * somebody changed pred under us, so start
+ * over from the top.
+ *******************************************/
+template <class K, class V>
+bool ConcurrentSkipList <K, V> :: locate(const K & key,
+                                         SkipNode<K, V> ** preds,
+                                         SkipNode<K, V> ** succs)
+{
+   typedef SkipNode<K, V> Node;
+
+retry:
+   Node * pred = head;
+   for (int level = MAX_LEVEL - 1; level >= 0; level--)
+   {
+      Node * curr = Node::ptr(pred->pNext[level].load(memory_order_acquire));
+      while (curr)
+      {
+         uintptr_t succ = curr->pNext[level].load(memory_order_acquire);
+         while (Node::marked(succ))
+         {
+            // curr is being erased, take it off this level
+            uintptr_t expected = Node::link(curr);
+            if (!pred->pNext[level].compare_exchange_strong(expected, Node::link(Node::ptr(succ))))
+               goto retry;
+            curr = Node::ptr(succ);
+            if (!curr)
+               break;
+            succ = curr->pNext[level].load(memory_order_acquire);
+         }
+
+         if (curr && curr->key < key)
+         {
+            pred = curr;
+            curr = Node::ptr(succ);
+         }
+         else
+            break;
+      }
+
+      preds[level] = pred;
+      succs[level] = curr;
+   }
+
+   return succs[0] && !(key < succs[0]->key);
+}
+
+/*******************************************
+ * ConcurrentSkipList :: insert
+ * The node is in the list once it is linked
+ * on level 0; the upper levels are only a
+ * short cut and are linked after.
+ *******************************************/
+template <class K, class V>
+bool ConcurrentSkipList <K, V> :: insert(const K & key, const V & value)
+{
+   typedef SkipNode<K, V> Node;
+   EpochGuard guard;
+
+   Node * preds[MAX_LEVEL];
+   Node * succs[MAX_LEVEL];
+   int topLevel = randomLevel();
+   Node * node = NULL;
+
+   while (true)
+   {
+      if (locate(key, preds, succs))
+      {
+         delete node; // never made it into the list
+         return false;
+      }
+
+      if (!node)
+         node = new Node(key, value, topLevel);
+      for (int level = 0; level <= topLevel; level++)
+         node->pNext[level].store(Node::link(succs[level]), memory_order_relaxed);
+
+      uintptr_t expected = Node::link(succs[0]);
+      if (preds[0]->pNext[0].compare_exchange_strong(expected, Node::link(node)))
+         break;
+   }
+   count.fetch_add(1, memory_order_relaxed);
+
+   // now the short cuts
+   for (int level = 1; level <= topLevel; level++)
+   {
+      while (true)
+      {
+         uintptr_t expected = Node::link(succs[level]);
+         if (preds[level]->pNext[level].compare_exchange_strong(expected, Node::link(node)))
+            break;
+
+         // something moved, find our place again
+         locate(key, preds, succs);
+         uintptr_t mine = node->pNext[level].load();
+         if (Node::marked(mine))
+            break;
+         if (!node->pNext[level].compare_exchange_strong(mine, Node::link(succs[level])))
+            break;
+      }
+   }
+
+   node->fullyLinked.store(true, memory_order_release);
+   return true;
+}
+
+/*******************************************
+ * ConcurrentSkipList :: erase
+ * Waits for an insert of the same node to
+ * finish its upper levels first, so no level
+ * can be linked after we unlink it.
+ *******************************************/
+template <class K, class V>
+bool ConcurrentSkipList <K, V> :: erase(const K & key)
+{
+   typedef SkipNode<K, V> Node;
+   EpochGuard guard;
+
+   Node * preds[MAX_LEVEL];
+   Node * succs[MAX_LEVEL];
+
+   if (!locate(key, preds, succs))
+      return false;
+
+   Node * node = succs[0];
+   while (!node->fullyLinked.load(memory_order_acquire))
+      this_thread::yield(); // an insert is still linking the upper levels
+
+   // mark the upper levels, top down
+   for (int level = node->topLevel; level >= 1; level--)
+   {
+      uintptr_t succ = node->pNext[level].load();
+      while (!Node::marked(succ))
+         node->pNext[level].compare_exchange_weak(succ, succ | 1);
+   }
+
+   // whoever marks level 0 erased it
+   uintptr_t succ = node->pNext[0].load();
+   while (true)
+   {
+      if (Node::marked(succ))
+         return false; // someone beat us to it
+      if (node->pNext[0].compare_exchange_strong(succ, succ | 1))
+         break;
+   }
+
+   count.fetch_sub(1, memory_order_relaxed);
+   locate(key, preds, succs);  // unlinks it from every level
+   Epoch::retire(node);
+   return true;
+}
+
+/*******************************************
+ * ConcurrentSkipList :: seek
+ * Readers never write, they just step over
+ * marked nodes.
+ *******************************************/
+template <class K, class V>
+SkipNode<K, V> * ConcurrentSkipList <K, V> :: seek(const K & key) const
+{
+   typedef SkipNode<K, V> Node;
+
+   Node * pred = head;
+   Node * curr = NULL;
+   for (int level = MAX_LEVEL - 1; level >= 0; level--)
+   {
+      curr = Node::ptr(pred->pNext[level].load(memory_order_acquire));
+      while (curr)
+      {
+         uintptr_t succ = curr->pNext[level].load(memory_order_acquire);
+         if (Node::marked(succ))
+            curr = Node::ptr(succ);
+         else if (curr->key < key)
+         {
+            pred = curr;
+            curr = Node::ptr(succ);
+         }
+         else
+            break;
+      }
+   }
+
+   return curr;
+}
+
+/*******************************************
+ * ConcurrentSkipList :: find
+ *******************************************/
+template <class K, class V>
+bool ConcurrentSkipList <K, V> :: find(const K & key, V & value) const
+{
+   EpochGuard guard;
+
+   SkipNode<K, V> * node = seek(key);
+   if (node == NULL || key < node->key)
+      return false;
+
+   value = node->value;
+   return true;
+}
+
+/*******************************************
+ * ConcurrentSkipList :: begin
+ *******************************************/
+template <class K, class V>
+SkipListIterator <K, V> ConcurrentSkipList <K, V> :: begin() const
+{
+   SkipListIterator <K, V> it(head);
+   return ++it;
+}
+
+/*******************************************
+ * ConcurrentSkipList :: lower_bound
+ *******************************************/
+template <class K, class V>
+SkipListIterator <K, V> ConcurrentSkipList <K, V> :: lower_bound(const K & key) const
+{
+   EpochGuard guard;
+   return SkipListIterator <K, V> (seek(key));
+}
+
+/**************************************************
+ * SKIP LIST ITERATOR
+ * Walks level 0, stepping over erased nodes.  The
+ * iterator holds an EpochGuard, so the node it is
+ * on stays valid even if it gets erased; use it on
+ * one thread and don't keep it around forever.
+ *************************************************/
+template <class K, class V>
+class SkipListIterator
+{
+public:
+   // initialize to direct p to some node
+   SkipListIterator(SkipNode<K, V> * p = NULL) : p(p) {}
+
+   // comparison operators
+   bool operator == (const SkipListIterator & rhs) const { return p == rhs.p; }
+   bool operator != (const SkipListIterator & rhs) const { return p != rhs.p; }
+
+   // the key and value.  Neither may change in the list.
+   const K & key()   const { return p->key;   }
+   const V & value() const { return p->value; }
+   const K & operator * () const { return p->key; }
+
+   // prefix increment
+   SkipListIterator <K, V> & operator ++ ()
+   {
+      do
+         p = SkipNode<K, V>::ptr(p->pNext[0].load(memory_order_acquire));
+      while (p && p->deleted());
+      return *this;
+   }
+
+   // postfix increment
+   SkipListIterator <K, V> operator ++ (int postfix)
+   {
+      SkipListIterator tmp(*this);
+      ++(*this);
+      return tmp;
+   }
+
+private:
+   EpochGuard guard;
+   SkipNode<K, V> * p;
+};
+
+#endif // SKIPLIST_H
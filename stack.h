@@ -36,7 +36,7 @@ public:
    ~Stack()             { if (cap) delete [] data;      }
 
    //Assignment operator
-   Stack <T> & operator=(Stack <T> & rhs);
+   Stack <T> & operator=(const Stack <T> & rhs);
 
    // Is the stack empty?
    bool empty() const   { return numItems == 0; }
@@ -58,6 +58,9 @@ public:
 
    // Returns the top item on the stack
    T & top()    throw (const char *);
+
+   // Same, for a const Stack
+   const T & const_top() const throw (const char *);
 };
 
 /*******************************************
@@ -142,8 +145,11 @@ Stack <T> :: Stack(int cap) throw (const char *)
 * Overrides = to copy any value.
 ************************************/
 template <class T>
-Stack <T> & Stack <T> :: operator=(Stack <T> & rhs)
+Stack <T> & Stack <T> :: operator=(const Stack <T> & rhs)
 {
+   if (this == &rhs)
+      return *this;
+
       // stop those memory leaks
    delete [] data;
 
@@ -187,6 +193,19 @@ T & Stack <T> :: top()   throw (const char *)
       return data[numItems - 1];
 }
 
+/*******************************************
+ * Stack :: const_top
+ * Returns the top item on a const stack.
+ *******************************************/
+template <class T>
+const T & Stack <T> :: const_top() const  throw (const char *)
+{
+   if (numItems <= 0)
+      throw "ERROR: Unable to reference the element from an empty Stack";
+   else
+      return data[numItems - 1];
+}
+
 /*****************************************
 * Stack::push
 * Adds an object onto the Stack
@@ -0,0 +1,286 @@
+/***************************************************************
+ * File: staticset.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the StaticSet class.  A
+ *    read-only Set for data built once and searched many times.
+ * The items are laid out in Eytzinger order: a complete binary
+ * search tree stored breadth first, root at 1, the children of k at
+ * 2k and 2k + 1.  A search then reads the top of the tree from the
+ * same few cache lines every time, and all 16 great-grandchildren
+ * of k sit next to each other at 16k, so they can be prefetched
+ * four levels before the search needs them.  The tree starts on a
+ * 64-byte boundary so that, for 4-byte items, those 16 are exactly
+ * one cache line.
+ ***************************************************************/
+#ifndef STATICSET_H
+#define STATICSET_H
+
+#include "set.h"
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <new>
+
+using namespace std;
+
+// forward declaration for StaticSetIterator
+template <class T>
+class StaticSetIterator;
+
+/************************************************
+ * StaticSet
+ * Frozen from a Set.  Walks in order like a Set,
+ * but there is no insert or erase.
+ ***********************************************/
+template <class T>
+class StaticSet
+{
+public:
+   // Default constructor : empty
+   StaticSet() : storage(NULL), tree(NULL), numItems(0) {}
+
+   // Freeze a Set
+   StaticSet(const Set <T> & set) throw (const char *);
+
+   // Copy constructor
+   StaticSet(const StaticSet & rhs) throw (const char *);
+
+   // Destructor
+   ~StaticSet()         { release(); }
+
+   // Assignment operator
+   StaticSet & operator = (const StaticSet & rhs) throw (const char *);
+
+   bool empty() const   { return numItems == 0; }
+   int size() const     { return numItems;      }
+
+   // the first item not less than t, or end()
+   StaticSetIterator <T> lower_bound(const T & t) const
+   {
+      return StaticSetIterator <T> (tree, numItems, search(t));
+   }
+
+   // the item equal to t, or end()
+   StaticSetIterator <T> find(const T & t) const
+   {
+      int k = search(t);
+      if (k && !(t < tree[k]))
+         return StaticSetIterator <T> (tree, numItems, k);
+      return end();
+   }
+
+   // is t in the set?
+   bool contains(const T & t) const
+   {
+      int k = search(t);
+      return k && !(t < tree[k]);
+   }
+
+   // in order, smallest first
+   StaticSetIterator <T> begin() const
+   {
+      return StaticSetIterator <T> (tree, numItems, StaticSetIterator<T>::first(numItems));
+   }
+   StaticSetIterator <T> end() const
+   {
+      return StaticSetIterator <T> (tree, numItems, 0);
+   }
+
+private:
+   // tree position of the first item not less than t, 0 if none
+   int search(const T & t) const;
+
+   // room for n items, and give it back
+   void allocate(int n) throw (const char *);
+   void release();
+
+   char * storage;  // what was allocated
+   T * tree;        // numItems + 1 items in storage, lined up on
+                    // 64 bytes, tree[0] unused
+   int numItems;
+};
+
+/**************************************************
+ * StaticSet ITERATOR
+ * Steps to the in-order successor in the tree.
+ * Position 0 is the end.
+ *************************************************/
+template <class T>
+class StaticSetIterator
+{
+public:
+   StaticSetIterator() : tree(NULL), n(0), k(0) {}
+   StaticSetIterator(const T * tree, int n, int k) : tree(tree), n(n), k(k) {}
+
+   bool operator != (const StaticSetIterator & rhs) const { return k != rhs.k; }
+   bool operator == (const StaticSetIterator & rhs) const { return k == rhs.k; }
+
+   // dereference operator
+   const T & operator * () const { return tree[k]; }
+
+   // prefix increment
+   StaticSetIterator & operator ++ ()
+   {
+      k = next(k, n);
+      return *this;
+   }
+
+   // postfix increment
+   StaticSetIterator operator ++ (int)
+   {
+      StaticSetIterator tmp(*this);
+      ++(*this);
+      return tmp;
+   }
+
+   // position of the smallest of n items
+   static int first(int n)
+   {
+      if (n == 0)
+         return 0;
+      int k = 1;
+      while (2 * k <= n)
+         k *= 2;
+      return k;
+   }
+
+   // position of the item after the one at k, 0 if none
+   static int next(int k, int n)
+   {
+      if (2 * k + 1 <= n)
+      {
+         // leftmost of the right subtree
+         k = 2 * k + 1;
+         while (2 * k <= n)
+            k *= 2;
+      }
+      else
+      {
+         // up past every right turn, then one more
+         while (k & 1)
+            k >>= 1;
+         k >>= 1;
+      }
+      return k;
+   }
+
+private:
+   const T * tree;
+   int n;
+   int k;
+};
+
+/*******************************************
+ * StaticSet :: FREEZE CONSTRUCTOR
+ * The Set is sorted, so an in-order walk of
+ * the tree positions takes its items in turn.
+ *******************************************/
+template <class T>
+StaticSet <T> :: StaticSet(const Set <T> & set) throw (const char *)
+   : storage(NULL), tree(NULL), numItems(0)
+{
+   allocate(set.numItems);
+
+   int k = StaticSetIterator<T>::first(numItems);
+   for (int i = 0; i < numItems; i++)
+   {
+      tree[k] = set.data[i];
+      k = StaticSetIterator<T>::next(k, numItems);
+   }
+}
+
+/*******************************************
+ * StaticSet :: COPY CONSTRUCTOR
+ *******************************************/
+template <class T>
+StaticSet <T> :: StaticSet(const StaticSet <T> & rhs) throw (const char *)
+   : storage(NULL), tree(NULL), numItems(0)
+{
+   allocate(rhs.numItems);
+
+   for (int k = 1; k <= numItems; k++)
+      tree[k] = rhs.tree[k];
+}
+
+/*******************************************
+ * StaticSet :: ASSIGNMENT OPERATOR
+ *******************************************/
+template <class T>
+StaticSet <T> & StaticSet <T> :: operator = (const StaticSet <T> & rhs)
+   throw (const char *)
+{
+   if (this != &rhs)
+   {
+      StaticSet <T> copy(rhs);
+      swap(storage, copy.storage);
+      swap(tree, copy.tree);
+      swap(numItems, copy.numItems);
+   }
+   return *this;
+}
+
+/*******************************************
+ * StaticSet :: allocate
+ * One spare cache line so the tree can start
+ * on a 64-byte boundary, the same trick as
+ * BloomFilter
+ *******************************************/
+template <class T>
+void StaticSet <T> :: allocate(int n) throw (const char *)
+{
+   assert(storage == NULL);
+   try
+   {
+      storage = new char[(n + 1) * sizeof(T) + 63];
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate buffer";
+   }
+   tree = (T *)(((size_t)storage + 63) & ~(size_t)63);
+   for (int k = 0; k <= n; k++)
+      new (tree + k) T;
+   numItems = n;
+}
+
+/*******************************************
+ * StaticSet :: release
+ *******************************************/
+template <class T>
+void StaticSet <T> :: release()
+{
+   if (storage == NULL)
+      return;
+   for (int k = 0; k <= numItems; k++)
+      tree[k].~T();
+   delete [] storage;
+   storage = NULL;
+   tree = NULL;
+   numItems = 0;
+}
+
+/*******************************************
+ * StaticSet :: search
+ * Go left or right with arithmetic instead
+ * of a branch: k becomes 2k + (tree[k] < t).
+ * Falling off the bottom, the bits of k are
+ * the turns taken, and the last left turn
+ * (the last 0 bit) is the answer, so shift
+ * off the trailing right turns and that 0.
+ * Meanwhile the block four levels below k
+ * is on its way into the cache.
+ *******************************************/
+template <class T>
+int StaticSet <T> :: search(const T & t) const
+{
+   // 2k and 16k outgrow an int long before numItems does
+   size_t k = 1;
+   while (k <= (size_t)numItems)
+   {
+      __builtin_prefetch(tree + k * 16);
+      k = 2 * k + (tree[k] < t);
+   }
+   return (int)(k >> __builtin_ffsll(~(long long)k));
+}
+
+#endif // STATICSET_H
@@ -0,0 +1,398 @@
+/***************************************************************
+ * File: threadpool.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the ThreadPool class.
+ *    Each worker owns a WorkStealingDeque of tasks.  A worker
+ * runs its own tasks newest first and, when it runs dry, steals
+ * the oldest task from a random worker.  Tasks are grouped in a
+ * TaskGroup so a caller can spawn() a batch and wait() for it,
+ * and the waiting thread helps run tasks instead of blocking.
+ ***************************************************************/
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "workstealing.h"
+#include "queue.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/************************************************
+ * TaskGroup
+ * Counts the tasks spawned into it that have not
+ * finished.  The first exception thrown by one
+ * of its tasks is handed back by wait().
+ ***********************************************/
+class TaskGroup
+{
+public:
+   TaskGroup() : pending(0) {}
+
+   atomic<int> pending;     // tasks not yet finished
+   exception_ptr error;     // first exception thrown by a task
+   mutex errorLock;         // guards error
+};
+
+/************************************************
+ * ThreadPool
+ ***********************************************/
+class ThreadPool
+{
+public:
+   // non-default constructor : 0 threads means one per core
+   ThreadPool(int numThreads = 0);
+
+   // destructor : finish the queued work and join the workers
+   ~ThreadPool();
+
+   // number of worker threads
+   int size() const { return (int)workers.size(); }
+
+   // run fn on some worker as part of group
+   void spawn(TaskGroup & group, const function<void()> & fn);
+
+   // run tasks until everything spawned into group is done
+   void wait(TaskGroup & group);
+
+   // call fn(lo, hi) over [begin, end) in pieces of at most grain items
+   template <class F>
+   void parallel_for(int begin, int end, int grain, F fn);
+
+   // the one pool the containers and sorts share
+   static ThreadPool & shared()
+   {
+      static ThreadPool pool;
+      return pool;
+   }
+
+private:
+   // a unit of work
+   struct Task
+   {
+      function<void()> fn;
+      TaskGroup * group;
+   };
+
+   // what each worker thread owns
+   struct Worker
+   {
+      WorkStealingDeque<Task *> tasks;
+      thread handle;
+      unsigned int seed;     // for picking a victim
+   };
+
+   // the loop each worker thread runs
+   void run(int index);
+
+   // find a task: our own first, then steal, then the inject queue
+   Task * findTask(int index, unsigned int & seed);
+
+   // run one task and mark it done in its group
+   void execute(Task * task);
+
+   // split [begin, end) in half until it is small enough
+   template <class F>
+   void split(TaskGroup & group, int begin, int end, int grain, F fn);
+
+   // which worker of which pool is this thread?  (-1 if none)
+   static int & workerIndex()
+   {
+      static thread_local int index = -1;
+      return index;
+   }
+   static ThreadPool *& workerPool()
+   {
+      static thread_local ThreadPool * pool = NULL;
+      return pool;
+   }
+
+   // no copying
+   ThreadPool(const ThreadPool & rhs);
+   ThreadPool & operator = (const ThreadPool & rhs);
+
+   vector<Worker *> workers;
+   Queue<Task *> inject;             // tasks spawned from outside the pool
+   mutex injectLock;                 // guards inject
+   condition_variable wakeUp;        // sleeping workers wait on this
+   unsigned long long numSignals;    // bumped to wake a sleeper, guarded by injectLock
+   atomic<int> numSleeping;          // workers in, or about to be in, wakeUp.wait
+   atomic<bool> stopping;
+};
+
+/*******************************************
+ * ThreadPool :: NON-DEFAULT CONSTRUCTOR
+ *******************************************/
+inline ThreadPool :: ThreadPool(int numThreads)
+   : numSignals(0), numSleeping(0), stopping(false)
+{
+   if (numThreads <= 0)
+      numThreads = (int)thread::hardware_concurrency();
+   if (numThreads <= 0)
+      numThreads = 1;
+
+   for (int i = 0; i < numThreads; i++)
+   {
+      workers.push_back(new Worker);
+      workers[i]->seed = 2654435761u * (i + 1);
+   }
+
+   // start them only once every deque exists, they steal from each other
+   for (int i = 0; i < numThreads; i++)
+      workers[i]->handle = thread(&ThreadPool::run, this, i);
+}
+
+/*******************************************
+ * ThreadPool :: DESTRUCTOR
+ *******************************************/
+inline ThreadPool :: ~ThreadPool()
+{
+   {
+      lock_guard<mutex> lock(injectLock);
+      stopping.store(true);
+   }
+   wakeUp.notify_all();
+
+   // join them all before freeing any, the others may still steal
+   for (size_t i = 0; i < workers.size(); i++)
+      workers[i]->handle.join();
+   for (size_t i = 0; i < workers.size(); i++)
+      delete workers[i];
+}
+
+/*******************************************
+ * ThreadPool :: spawn
+ * A worker pushes onto its own deque, anyone
+ * else goes through the inject queue.  Either
+ * way, if someone is asleep, bump numSignals
+ * under injectLock and wake one of them.
+ *******************************************/
+inline void ThreadPool :: spawn(TaskGroup & group, const function<void()> & fn)
+{
+   Task * task = new Task;
+   task->fn = fn;
+   task->group = &group;
+   group.pending.fetch_add(1);
+
+   if (workerPool() == this)
+      workers[workerIndex()]->tasks.push_back(task);
+   else
+   {
+      lock_guard<mutex> lock(injectLock);
+      inject.push(task);
+   }
+
+   // pairs with the fence in run(): either a worker on its way to
+   // sleep finds this task, or we see it counted in numSleeping
+   atomic_thread_fence(memory_order_seq_cst);
+   if (numSleeping.load() > 0)
+   {
+      lock_guard<mutex> lock(injectLock);
+      numSignals++;
+      wakeUp.notify_one();
+   }
+}
+
+/*******************************************
+ * ThreadPool :: findTask
+ *******************************************/
+inline ThreadPool::Task * ThreadPool :: findTask(int index, unsigned int & seed)
+{
+   Task * task = NULL;
+
+   // our own work first
+   if (index >= 0 && workers[index]->tasks.pop_back(task))
+      return task;
+
+   // then try a few random victims
+   int num = size();
+   for (int tries = 0; tries < num * 2; tries++)
+   {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      int victim = (int)(seed % num);
+      if (victim != index && workers[victim]->tasks.steal(task))
+         return task;
+   }
+
+   // last, the inject queue
+   lock_guard<mutex> lock(injectLock);
+   if (!inject.empty())
+   {
+      task = inject.front();
+      inject.pop();
+      return task;
+   }
+
+   return NULL;
+}
+
+/*******************************************
+ * ThreadPool :: execute
+ *******************************************/
+inline void ThreadPool :: execute(Task * task)
+{
+   TaskGroup * group = task->group;
+   try
+   {
+      task->fn();
+   }
+   catch (...)
+   {
+      lock_guard<mutex> lock(group->errorLock);
+      if (!group->error)
+         group->error = current_exception();
+   }
+
+   delete task;
+   group->pending.fetch_sub(1);
+}
+
+/*******************************************
+ * ThreadPool :: run
+ * Spins a little when there is nothing to
+ * do, then sleeps until spawn() signals.  To
+ * not miss a task pushed while we doze off we
+ * note numSignals, count ourselves asleep, and
+ * only then look for work one last time.
+ *******************************************/
+inline void ThreadPool :: run(int index)
+{
+   workerIndex() = index;
+   workerPool() = this;
+   unsigned int & seed = workers[index]->seed;
+   int idle = 0;
+
+   while (true)
+   {
+      Task * task = findTask(index, seed);
+      if (task)
+      {
+         execute(task);
+         idle = 0;
+         continue;
+      }
+
+      if (stopping.load())
+         return;
+
+      if (++idle < 64)
+      {
+         this_thread::yield();
+         continue;
+      }
+
+      unsigned long long seen;
+      {
+         lock_guard<mutex> lock(injectLock);
+         seen = numSignals;
+      }
+      numSleeping.fetch_add(1);
+      atomic_thread_fence(memory_order_seq_cst);
+
+      // findTask only tries a few random victims, look at every deque
+      task = findTask(index, seed);
+      for (int i = 0; task == NULL && i < size(); i++)
+         if (i != index)
+            workers[i]->tasks.steal(task);
+      if (task == NULL)
+      {
+         unique_lock<mutex> lock(injectLock);
+         while (numSignals == seen && !stopping.load())
+            wakeUp.wait(lock);
+      }
+      numSleeping.fetch_sub(1);
+
+      if (task)
+         execute(task);
+      idle = 0;
+   }
+}
+
+/*******************************************
+ * ThreadPool :: wait
+ * The waiting thread runs tasks too, so a task
+ * that waits on its own children can't
+ * deadlock the pool.
+ *******************************************/
+inline void ThreadPool :: wait(TaskGroup & group)
+{
+   int index = workerPool() == this ? workerIndex() : -1;
+   unsigned int seed = 0x9e3779b9u;
+   unsigned int & useSeed = index >= 0 ? workers[index]->seed : seed;
+
+   while (group.pending.load() > 0)
+   {
+      Task * task = findTask(index, useSeed);
+      if (task)
+         execute(task);
+      else
+         this_thread::yield();
+   }
+
+   if (group.error)
+   {
+      exception_ptr error = group.error;
+      group.error = exception_ptr();
+      rethrow_exception(error);
+   }
+}
+
+/*******************************************
+ * ThreadPool :: split
+ * Spawns the upper half and keeps the lower
+ * half, so the deque holds the biggest pieces
+ * at the front where thieves take from.
+ *******************************************/
+template <class F>
+void ThreadPool :: split(TaskGroup & group, int begin, int end, int grain, F fn)
+{
+   while (end - begin > grain)
+   {
+      int mid = begin + (end - begin) / 2;
+      int hi = end;
+      spawn(group, [this, &group, mid, hi, grain, fn]()
+            { split(group, mid, hi, grain, fn); });
+      end = mid;
+   }
+
+   fn(begin, end);
+}
+
+/*******************************************
+ * ThreadPool :: parallel_for
+ * The pieces already spawned hold on to group,
+ * so even if our own piece throws we have to
+ * wait for them before group goes away.  The
+ * throw is kept like a task's would be and
+ * wait() hands back whichever came first.
+ *******************************************/
+template <class F>
+void ThreadPool :: parallel_for(int begin, int end, int grain, F fn)
+{
+   if (grain < 1)
+      grain = 1;
+   if (end <= begin)
+      return;
+
+   TaskGroup group;
+   try
+   {
+      split(group, begin, end, grain, fn);
+   }
+   catch (...)
+   {
+      lock_guard<mutex> lock(group.errorLock);
+      if (!group.error)
+         group.error = current_exception();
+   }
+   wait(group);
+}
+
+#endif // THREADPOOL_H
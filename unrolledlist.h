@@ -0,0 +1,433 @@
+/***********************************************************************
+ * Header:
+ *    UNROLLED LIST
+ * Summary:
+ *    This contains the UnrolledList class and UnrolledListIterator
+ * class, both of which are templates.  The list is a doubly-linked
+ * list of UnrolledNodes, each holding up to B items in an array, so
+ * walking the list touches one node per B items instead of one node
+ * per item.  A node that fills up is split in half, and a node that
+ * drops below half full takes items from (or is merged with) the
+ * node after it.  The iterator has the same interface as ListIterator.
+ * Author:
+ *    Ryan Walker
+ ************************************************************************/
+#ifndef UNROLLEDLIST_H
+#define UNROLLEDLIST_H
+
+#include <iostream>
+using namespace std;
+
+// forward declaration for UnrolledListIterator
+template <class T, int B>
+class UnrolledListIterator;
+
+/************************************************
+ * UnrolledNode
+ * Up to B items plus the links to its neighbors
+ ***********************************************/
+template <class T, int B>
+class UnrolledNode
+{
+public:
+	T data[B];							// the items, packed at the front
+	int count;							// how many of data are in use
+	UnrolledNode<T, B> * pNext;	// points to the next node
+	UnrolledNode<T, B> * pPrev;	// points to the previous node
+
+	UnrolledNode() : count(0), pNext(NULL), pPrev(NULL) {}
+};
+
+template <class T, int B = 32>
+class UnrolledList
+{
+	// splitting a full node in half has to leave something on each side
+	static_assert(B >= 2, "UnrolledList needs B >= 2 items per node");
+
+public:
+	int numItems;						// number of items in the List
+	UnrolledNode<T, B> * head;		// front of the doubley linked-list
+	UnrolledNode<T, B> * tail;		// tail of the doubley linked-list
+
+	// Default Constructor
+	UnrolledList() : numItems(0), head(NULL), tail(NULL) {}
+
+	// Copy Constructor
+	UnrolledList(const UnrolledList & rhs) : numItems(0), head(NULL), tail(NULL)
+	{
+		*this = rhs;
+	}
+
+	// Destructor
+	~UnrolledList()				{ clear(); }
+
+	// is this List empty?
+	bool empty() const 			{ return numItems == 0; }
+
+	// clears all List data and sets head and tail to NULL
+	void clear();
+
+	// returns the number of items in the List as an int
+	int size() const				{ return numItems;		}
+
+	// add the data passed in onto the end of the List
+	void push_back(const T & data)  throw (const char *)	{ insert(end(), data);   }
+
+	// add the data passed in onto the front of the List
+	void push_front(const T & data) throw (const char *)	{ insert(begin(), data); }
+
+	// returns the front data
+	T & front() throw (const char *);
+
+	// returns the back data
+	T & back()  throw (const char *);
+
+	// adds data in front of it, returns where it went
+	UnrolledListIterator<T, B> insert(UnrolledListIterator<T, B> it, const T & data)
+		throw (const char *);
+
+	// deletes the item at it, returns the item after it
+	UnrolledListIterator<T, B> remove(UnrolledListIterator<T, B> it) throw (const char *);
+
+	// assignment operator
+	UnrolledList <T, B> & operator = (const UnrolledList & rhs);
+
+	// iterates from the head of the List till it hits NULL
+	UnrolledListIterator <T, B> begin()
+	{
+		return UnrolledListIterator <T, B>(head, 0);
+	}
+
+	// iterates from the tail of the List till it hits NULL
+	UnrolledListIterator <T, B> rbegin()
+	{
+		return UnrolledListIterator <T, B>(tail, tail ? tail->count - 1 : 0);
+	}
+
+	// end of the List at the tail
+	UnrolledListIterator <T, B> end()  { return UnrolledListIterator <T, B>(NULL, 0); }
+
+	// end of the List at the head
+	UnrolledListIterator <T, B> rend() { return UnrolledListIterator <T, B>(NULL, 0); }
+
+private:
+	// move the top half of node into a new node after it
+	void split(UnrolledNode<T, B> * node);
+
+	// unlink node from the List and delete it
+	void unlink(UnrolledNode<T, B> * node);
+};
+
+/************************************
+* UnrolledList <T, B> :: clear
+************************************/
+template <class T, int B>
+void UnrolledList <T, B> :: clear()
+{
+	while (head)
+	{
+		UnrolledNode<T, B> *next = head->pNext;
+		delete head;
+		head = next;
+	}
+	tail = NULL;
+	numItems = 0;
+}
+
+/************************************
+* UnrolledList <T, B> :: front
+************************************/
+template <class T, int B>
+T & UnrolledList <T, B> :: front() throw (const char *)
+{
+	if (head == NULL)
+		throw "ERROR: Unable to access data from an empty list";
+	return head->data[0];
+}
+
+/************************************
+* UnrolledList <T, B> :: back
+************************************/
+template <class T, int B>
+T & UnrolledList <T, B> :: back() throw (const char *)
+{
+	if (tail == NULL)
+		throw "ERROR: Unable to access data from an empty list";
+	return tail->data[tail->count - 1];
+}
+
+/************************************
+* UnrolledList <T, B> :: split
+* The new node takes the top half so
+* both halves have room to grow.
+************************************/
+template <class T, int B>
+void UnrolledList <T, B> :: split(UnrolledNode<T, B> * node)
+{
+	UnrolledNode<T, B> * nNode = new UnrolledNode<T, B>;
+	int keep = node->count / 2;
+
+	for (int i = keep; i < node->count; i++)
+		nNode->data[i - keep] = node->data[i];
+	nNode->count = node->count - keep;
+	node->count = keep;
+
+	// link it in after node
+	nNode->pPrev = node;
+	nNode->pNext = node->pNext;
+	if (node->pNext)
+		node->pNext->pPrev = nNode;
+	else
+		tail = nNode;
+	node->pNext = nNode;
+}
+
+/************************************
+* UnrolledList <T, B> :: unlink
+************************************/
+template <class T, int B>
+void UnrolledList <T, B> :: unlink(UnrolledNode<T, B> * node)
+{
+	if (node->pPrev)
+		node->pPrev->pNext = node->pNext;
+	else
+		head = node->pNext;
+
+	if (node->pNext)
+		node->pNext->pPrev = node->pPrev;
+	else
+		tail = node->pPrev;
+
+	delete node;
+}
+
+/************************************
+* UnrolledList <T, B> :: insert
+* Shifts at most B items, splitting
+* the node first if it is full.
+************************************/
+template <class T, int B>
+UnrolledListIterator<T, B> UnrolledList <T, B> :: insert(UnrolledListIterator <T, B> it,
+                                                         const T & data) throw (const char *)
+{
+	try
+	{
+		UnrolledNode<T, B> * node = it.p;
+		int pos = it.i;
+
+		if (head == NULL)				// make a new List
+		{
+			head = tail = new UnrolledNode<T, B>;
+			node = head;
+			pos = 0;
+		}
+		else if (node == NULL)		// insert at end of list
+		{
+			node = tail;
+			pos = tail->count;
+		}
+
+		if (node->count == B)
+		{
+			split(node);
+			if (pos > node->count)	// it belongs in the new half
+			{
+				pos -= node->count;
+				node = node->pNext;
+			}
+		}
+
+		for (int i = node->count; i > pos; i--)
+			node->data[i] = node->data[i - 1];	// shift data to the right
+		node->data[pos] = data;
+		node->count++;
+		numItems++;	// we have another item
+
+		return UnrolledListIterator<T, B>(node, pos);
+	}
+	catch (std::bad_alloc)
+	{
+		throw "ERROR: Unable to allocate a new node for list";
+	}
+}
+
+/************************************
+* UnrolledList <T, B> :: remove
+* Shifts at most B items, then tops
+* the node back up from the next node
+* if it fell below half full.
+************************************/
+template <class T, int B>
+UnrolledListIterator<T, B> UnrolledList <T, B> :: remove(UnrolledListIterator<T, B> it)
+	throw (const char *)
+{
+	if (it == end())
+		throw "ERROR: unable to remove from an invalid location in a list";
+
+	UnrolledNode<T, B> * node = it.p;
+	int pos = it.i;
+
+	for (int i = pos; i < node->count - 1; i++)
+		node->data[i] = node->data[i + 1];	// shift data to the left
+	node->count--;
+	numItems--;	// we're losing an item
+
+	UnrolledNode<T, B> * next = node->pNext;
+	if (node->count < B / 2 && next)
+	{
+		if (node->count + next->count <= B)
+		{
+			// merge: next moves in with us
+			for (int i = 0; i < next->count; i++)
+				node->data[node->count + i] = next->data[i];
+			node->count += next->count;
+			unlink(next);
+		}
+		else
+		{
+			// borrow: even out the two nodes
+			int move = (next->count - node->count) / 2;
+			for (int i = 0; i < move; i++)
+				node->data[node->count + i] = next->data[i];
+			for (int i = move; i < next->count; i++)
+				next->data[i - move] = next->data[i];
+			node->count += move;
+			next->count -= move;
+		}
+	}
+
+	if (node->count == 0)
+	{
+		next = node->pNext;
+		unlink(node);
+		return UnrolledListIterator<T, B>(next, 0);
+	}
+
+	if (pos < node->count)
+		return UnrolledListIterator<T, B>(node, pos);
+	return UnrolledListIterator<T, B>(node->pNext, 0);
+}
+
+/************************************
+* UnrolledList <T, B> :: operator=
+* Copies whole nodes at a time.
+************************************/
+template <class T, int B>
+UnrolledList <T, B> & UnrolledList <T, B> :: operator = (const UnrolledList & rhs)
+{
+	if (this == &rhs)
+		return *this;
+
+	clear();
+	for (UnrolledNode<T, B> *node = rhs.head; node; node = node->pNext)
+	{
+		UnrolledNode<T, B> *copy = new UnrolledNode<T, B>;
+		for (int i = 0; i < node->count; i++)
+			copy->data[i] = node->data[i];
+		copy->count = node->count;
+
+		copy->pPrev = tail;
+		if (tail)
+			tail->pNext = copy;
+		else
+			head = copy;
+		tail = copy;
+	}
+	numItems = rhs.numItems;
+
+	// return *this as the copied List
+	return *this;
+}
+
+/**************************************************
+ * UNROLLED LIST ITERATOR
+ * A node and an index into that node.  The end
+ * of the List is a NULL node.
+ *************************************************/
+template <class T, int B>
+class UnrolledListIterator
+{
+  public:
+   // default constructor
+   UnrolledListIterator() : p(NULL), i(0) {}
+
+   // initialize to direct p to some item
+   UnrolledListIterator(UnrolledNode<T, B> * p, int i) : p(p), i(i) {}
+
+   // copy constructor
+   UnrolledListIterator(const UnrolledListIterator & rhs) { *this = rhs; }
+
+   friend class UnrolledList<T, B>;
+
+   // assignment operator
+   UnrolledListIterator & operator = (const UnrolledListIterator & rhs)
+   {
+      this->p = rhs.p;
+      this->i = rhs.i;
+      return *this;
+   }
+
+   // comparison operator
+   bool operator == (const UnrolledListIterator & rhs) const
+   {
+      return rhs.p == this->p && rhs.i == this->i;
+   }
+
+   // not equals operator
+   bool operator != (const UnrolledListIterator & rhs) const
+   {
+      return !(*this == rhs);
+   }
+
+   // dereference operator
+   T & operator * ()
+   {
+      return p->data[i];
+   }
+
+   // prefix increment
+   UnrolledListIterator <T, B> & operator ++ ()
+   {
+      if (++i == p->count)
+      {
+         p = p->pNext;
+         i = 0;
+      }
+      return *this;
+   }
+
+   // postfix increment
+   UnrolledListIterator <T, B> operator++(int postfix)
+   {
+      UnrolledListIterator tmp(*this);
+      ++(*this);
+      return tmp;
+   }
+
+   // prefix decrement
+   UnrolledListIterator <T, B> & operator --()
+   {
+      if (i > 0)
+         i--;
+      else
+      {
+         p = p->pPrev;
+         i = p ? p->count - 1 : 0;
+      }
+      return *this;
+   }
+
+   // postfix decrement
+   UnrolledListIterator <T, B> operator--(int postfix)
+   {
+      UnrolledListIterator tmp(*this);
+      --(*this);
+      return tmp;
+   }
+
+  private:
+   UnrolledNode<T, B> * p;
+   int i;
+};
+
+#endif // UNROLLEDLIST_H
@@ -0,0 +1,202 @@
+/***************************************************************
+ * File: workstealing.h
+ * Author: Ryan Walker
+ * Purpose: Contains the definition of the WorkStealingDeque class.
+ *    A lock-free Chase-Lev deque.  Only the thread that owns the
+ * deque may push_back() and pop_back(); any other thread may
+ * steal() from the front.  T should be something cheap to copy,
+ * like a pointer to a task.
+ ***************************************************************/
+#ifndef WORKSTEALING_H
+#define WORKSTEALING_H
+
+#include <atomic>
+#include <cassert>
+#include <vector>
+
+using namespace std;
+
+/************************************************
+ * WorkStealingDeque
+ * The items sit in a circular array that the
+ * owner doubles when it is full.  Thieves may
+ * still be reading the old array, so old arrays
+ * are kept until the deque is destroyed.
+ ***********************************************/
+template <class T>
+class WorkStealingDeque
+{
+public:
+   // non-default constructor : pre-allocate (rounded up to a power of two)
+   WorkStealingDeque(int cap = 64);
+
+   // destructor : free the array and every array it outgrew
+   ~WorkStealingDeque();
+
+   // owner only : add an item to the back
+   void push_back(const T & t);
+
+   // owner only : take the item at the back.  False if empty.
+   bool pop_back(T & t);
+
+   // any thread : take the item at the front.  False if empty
+   // or if another thread got there first.
+   bool steal(T & t);
+
+   // a guess at the number of items, good for heuristics only
+   int size() const
+   {
+      long long b = bottom.load(memory_order_relaxed);
+      long long t = top.load(memory_order_relaxed);
+      return b > t ? (int)(b - t) : 0;
+   }
+
+   // a guess at whether there is anything to steal
+   bool empty() const { return size() == 0; }
+
+private:
+   // a circular array of atomic slots
+   struct Array
+   {
+      long long cap;
+      atomic<T> * data;
+
+      Array(long long cap) : cap(cap), data(new atomic<T>[cap]) {}
+      ~Array() { delete [] data; }
+
+      T get(long long i) const       { return data[i & (cap - 1)].load(memory_order_relaxed); }
+      void put(long long i, T t)     { data[i & (cap - 1)].store(t, memory_order_relaxed); }
+   };
+
+   // make a new array twice the size holding the same items
+   Array * grow(Array * a, long long b, long long t);
+
+   // no copying, thieves may hold pointers into us
+   WorkStealingDeque(const WorkStealingDeque & rhs);
+   WorkStealingDeque & operator = (const WorkStealingDeque & rhs);
+
+   atomic<long long> top;       // next item a thief will take
+   atomic<long long> bottom;    // next free slot at the owner's end
+   atomic<Array *> array;       // the current array
+   vector<Array *> garbage;     // arrays we outgrew
+};
+
+/*******************************************
+ * WorkStealingDeque :: NON-DEFAULT CONSTRUCTOR
+ *******************************************/
+template <class T>
+WorkStealingDeque <T> :: WorkStealingDeque(int cap) : top(0), bottom(0)
+{
+   long long size = 2;
+   while (size < cap)
+      size *= 2;
+   array.store(new Array(size), memory_order_relaxed);
+}
+
+/*******************************************
+ * WorkStealingDeque :: DESTRUCTOR
+ *******************************************/
+template <class T>
+WorkStealingDeque <T> :: ~WorkStealingDeque()
+{
+   delete array.load(memory_order_relaxed);
+   for (size_t i = 0; i < garbage.size(); i++)
+      delete garbage[i];
+}
+
+/*******************************************
+ * WorkStealingDeque :: grow
+ * Copies the live items [t, b) into an array
+ * twice the size.
+ *******************************************/
+template <class T>
+typename WorkStealingDeque <T> :: Array *
+WorkStealingDeque <T> :: grow(Array * a, long long b, long long t)
+{
+   Array * nArray = new Array(a->cap * 2);
+   for (long long i = t; i < b; i++)
+      nArray->put(i, a->get(i));
+
+   garbage.push_back(a);
+   array.store(nArray, memory_order_release);
+   return nArray;
+}
+
+/*******************************************
+ * WorkStealingDeque :: push_back
+ *******************************************/
+template <class T>
+void WorkStealingDeque <T> :: push_back(const T & item)
+{
+   long long b = bottom.load(memory_order_relaxed);
+   long long t = top.load(memory_order_acquire);
+   Array * a = array.load(memory_order_relaxed);
+
+   if (b - t > a->cap - 1)
+      a = grow(a, b, t);
+
+   a->put(b, item);
+   bottom.store(b + 1, memory_order_release);   // publish the item to thieves
+}
+
+/*******************************************
+ * WorkStealingDeque :: pop_back
+ * Only races with thieves when there is one
+ * item left, then whoever wins the CAS on top
+ * gets it.
+ *******************************************/
+template <class T>
+bool WorkStealingDeque <T> :: pop_back(T & item)
+{
+   long long b = bottom.load(memory_order_relaxed) - 1;
+   Array * a = array.load(memory_order_relaxed);
+   bottom.store(b, memory_order_relaxed);
+   atomic_thread_fence(memory_order_seq_cst);
+   long long t = top.load(memory_order_relaxed);
+
+   // empty, put bottom back
+   if (t > b)
+   {
+      bottom.store(b + 1, memory_order_relaxed);
+      return false;
+   }
+
+   item = a->get(b);
+   if (t == b)
+   {
+      // last item, race the thieves for it
+      bool won = top.compare_exchange_strong(t, t + 1,
+                                             memory_order_seq_cst,
+                                             memory_order_relaxed);
+      bottom.store(b + 1, memory_order_relaxed);
+      return won;
+   }
+
+   return true;
+}
+
+/*******************************************
+ * WorkStealingDeque :: steal
+ *******************************************/
+template <class T>
+bool WorkStealingDeque <T> :: steal(T & item)
+{
+   long long t = top.load(memory_order_acquire);
+   atomic_thread_fence(memory_order_seq_cst);
+   long long b = bottom.load(memory_order_acquire);
+
+   if (t >= b)
+      return false;
+
+   Array * a = array.load(memory_order_acquire);
+   T stolen = a->get(t);
+   if (!top.compare_exchange_strong(t, t + 1,
+                                    memory_order_seq_cst,
+                                    memory_order_relaxed))
+      return false; // lost the race
+
+   item = stolen;
+   return true;
+}
+
+#endif // WORKSTEALING_H